@@ -1,7 +1,11 @@
 #include "compare.hpp"
+#include "game.hpp"
 
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <iomanip>
+#include <string>
 #include <vector>
 #include <tuple>
 
@@ -21,9 +25,64 @@ void test(T a, T b)
   std::cout << "compare(" << a << ", " << b << ") == " << compare(a, b) << '\n';
 }
 
+// A record with its own ordering, which takes precedence.
+struct version
+{
+  int major, minor;
+
+  friend std::strong_ordering operator<=>(version a, version b)
+  {
+    return b.major <=> a.major; // newest first
+  }
+
+  friend bool operator==(version, version) = default;
+};
+
 int main()
 {
+  using namespace lock3;
+
   test(0, 0);
   test(0, 42);
   test(42, 0);
+
+  // Classes are compared member by member.
+  game::ratio r1 {100, 50};
+  game::ratio r2 {100, 60};
+  assert(compare(r1, r2) < 0);
+  assert(equal(r1, r1) && !equal(r1, r2));
+
+  game::player p1 {"andrew", {100, 100}, {50, 50}};
+  game::player p2 {"andrew", {100, 90}, {50, 50}};
+  assert(compare(p1, p2) > 0);
+  assert(equal(p1, p1) && !equal(p1, p2));
+
+  // Floating point members make the ordering partial.
+  struct sample { int id; double value; };
+  static_assert(std::same_as<decltype(compare(sample(), sample())), std::partial_ordering>);
+  assert(compare(sample {1, 0.5}, sample {1, -0.5}) > 0);
+
+  // Tuples, ranges and strings.
+  assert(compare(std::make_tuple(1, 'a'), std::make_tuple(1, 'b')) < 0);
+  assert(compare(std::vector<int> {1, 2, 3}, std::vector<int> {1, 2}) > 0);
+  assert(compare(std::vector<int> {-1}, std::vector<int> {1}) < 0);
+  assert(equal(std::vector<game::ratio> {r1, r2}, std::vector<game::ratio> {r1, r2}));
+  assert(compare(std::string("sword"), std::string("swords")) < 0);
+
+  // User-defined comparisons are used when present.
+  assert(compare(version {2, 0}, version {1, 9}) < 0);
+
+  // Including for elements of ranges, whose bytes may differ while they
+  // compare equivalent.
+  std::vector<version> v1 {{2, 0}, {1, 0}};
+  std::vector<version> v2 {{2, 1}, {3, 0}};
+  assert(compare(v1, v2) > 0);
+
+  // Sort and deduplicate records without writing a comparator.
+  std::vector<game::ratio> ratios {{3, 1}, {1, 2}, {3, 1}, {1, 1}};
+  std::sort(ratios.begin(), ratios.end(), [](auto const& a, auto const& b) {
+    return compare(a, b) < 0;
+  });
+  ratios.erase(std::unique(ratios.begin(), ratios.end(), equal_to()), ratios.end());
+  assert(ratios.size() == 3 && ratios[0].current == 1 && ratios[2].max == 3);
 }
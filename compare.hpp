@@ -3,23 +3,137 @@
 
 #include "concepts.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <concepts>
 #include <ranges>
 #include <compare>
+#include <string_view>
+#include <tuple>
+#include <utility>
 
 #include <iostream> // FIXME: Remove this.
 
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
 namespace lock3
 {
+  namespace detail
+  {
+    // The strength of a comparison category: 0 for strong, 1 for weak, and
+    // 2 for partial orderings. The result of comparing a class is the
+    // weakest category of its members.
+    template<typename O>
+    constexpr int ordering_rank = 2;
+
+    template<>
+    constexpr int ordering_rank<std::strong_ordering> = 0;
+
+    template<>
+    constexpr int ordering_rank<std::weak_ordering> = 1;
+
+    template<int R>
+    using ordering_of_rank =
+      std::conditional_t<R == 0, std::strong_ordering,
+      std::conditional_t<R == 1, std::weak_ordering, std::partial_ordering>>;
+
+    // Returns true if compare and equal determine the order of `T` from its
+    // bytes alone: it is a scalar, or a basic data type without comparison
+    // operators of its own whose members are also structurally compared. A
+    // user-provided `operator<=>` or `operator==` may treat values with
+    // different bytes as equivalent.
+    template<typename T>
+    consteval bool is_structurally_compared()
+    {
+      namespace meta = std::experimental::meta;
+      if constexpr (std::is_scalar_v<T>)
+        return true;
+      else if constexpr (std::ranges::range<T> || std_product_type<T> ||
+                         std::three_way_comparable<T> || std::equality_comparable<T>)
+        return false;
+      else if constexpr (basic_data_type<T>) {
+        constexpr auto subobjects = meta::subobjects_of(^T, meta::is_data_member);
+        template for (constexpr meta::info sub : subobjects) {
+          using M = std::remove_cv_t<typename [:meta::type_of(sub):]>;
+          if constexpr (!is_structurally_compared<M>())
+            return false;
+        }
+        return true;
+      }
+      else
+        return false;
+    }
+
+    // A structurally compared class whose value is its object
+    // representation. These are equal exactly when their bytes are.
+    template<typename T>
+    concept bitwise_comparable_class =
+      class_type<T> &&
+      std::has_unique_object_representations_v<T> &&
+      is_structurally_compared<T>();
+
+    // A contiguous range of uniquely represented, structurally compared
+    // values. The first element at which two of these differ contains the
+    // first byte at which they differ.
+    template<typename R>
+    concept bitwise_comparable_range =
+      std::ranges::contiguous_range<R> &&
+      std::ranges::sized_range<R> &&
+      std::has_unique_object_representations_v<std::ranges::range_value_t<R>> &&
+      is_structurally_compared<std::ranges::range_value_t<R>>();
+
+    // Returns the offset of the first byte at which the `n` bytes at `a` and
+    // `b` differ, or `n` if they are the same.
+    inline std::size_t first_mismatch(unsigned char const* a,
+                                      unsigned char const* b,
+                                      std::size_t n) noexcept
+    {
+      std::size_t i = 0;
+#if defined(__SSE2__)
+      for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+        unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xffffu;
+        if (m != 0)
+          return i + std::countr_zero(m);
+      }
+#endif
+      for (; i + 8 <= n; i += 8) {
+        std::uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        if (x != y) {
+          if constexpr (std::endian::native == std::endian::little)
+            return i + std::countr_zero(x ^ y) / 8;
+          else
+            return i + std::countl_zero(x ^ y) / 8;
+        }
+      }
+      for (; i != n; ++i)
+        if (a[i] != b[i])
+          return i;
+      return n;
+    }
+
+    template<typename T>
+    unsigned char const* bytes_of(T const* p) noexcept
+    {
+      return reinterpret_cast<unsigned char const*>(p);
+    }
+  } // namespace detail
+
   // compare
 
   struct compare_fn
   {
     /// Compare integral types.
     template<std::integral T>
-    std::strong_ordering operator()(T a, T b) const noexcept
+    constexpr std::strong_ordering operator()(T a, T b) const noexcept
     {
       if (a < b)
         return std::strong_ordering::less;
@@ -30,7 +144,7 @@ namespace lock3
 
     /// Compare floating point types.
     template<std::floating_point T>
-    std::partial_ordering operator()(T a, T b) const noexcept
+    constexpr std::partial_ordering operator()(T a, T b) const noexcept
     {
       if (a == b)
         return std::partial_ordering::equivalent;
@@ -43,7 +157,7 @@ namespace lock3
 
     /// Compare enumeration types.
     template<enumeral T>
-    std::strong_ordering operator()(T a, T b) const noexcept
+    constexpr std::strong_ordering operator()(T a, T b) const noexcept
     {
       using Z = std::underlying_type_t<T>;
       return operator()(static_cast<Z>(a), static_cast<Z>(b));
@@ -52,7 +166,7 @@ namespace lock3
     /// Compare two pointers. In the case where pointers are non-equal, but but
     /// point not distinctly less or greater is unspecified.
     template<typename T>
-    std::strong_ordering operator()(T* p, T* q) const noexcept
+    constexpr std::strong_ordering operator()(T* p, T* q) const noexcept
     {
       if (p < q)
         return std::strong_ordering::less;
@@ -60,19 +174,255 @@ namespace lock3
         return std::strong_ordering::greater;
       return std::strong_ordering::equal;
     }
+
+    /// Compare classes and arrays.
+    ///
+    /// Strings compare their characters. Ranges compare their elements
+    /// lexicographically, and tuples and basic data types compare their
+    /// elements or members in order. A class with its own `operator<=>`
+    /// is compared with that instead. The result is the weakest ordering
+    /// of the elements or members compared.
+    template<typename T>
+      requires class_type<T> || std::is_array_v<T>
+    constexpr auto operator()(T const& a, T const& b) const
+    {
+      if constexpr (string_like<T>)
+        return std::string_view(a) <=> std::string_view(b);
+      else if constexpr (std::ranges::range<T>)
+        return compare_range(a, b);
+      else if constexpr (detail::std_product_type<T>)
+        return compare_tuple(a, b);
+      else if constexpr (std::three_way_comparable<T>)
+        return a <=> b;
+      else // basic_data_type<T>
+        return compare_data_type(a, b);
+    }
+
+    // Compare ranges lexicographically. For contiguous ranges of uniquely
+    // represented, structurally compared values, the first differing element
+    // is found by comparing bytes; only it and the lengths need to be
+    // compared as values.
+    template<std::ranges::range R>
+    constexpr auto compare_range(R const& a, R const& b) const
+    {
+      using T = std::ranges::range_value_t<R>;
+      using O = decltype(operator()(std::declval<T const&>(), std::declval<T const&>()));
+      if constexpr (detail::bitwise_comparable_range<R>) {
+        if (!std::is_constant_evaluated()) {
+          T const* x = std::ranges::data(a);
+          T const* y = std::ranges::data(b);
+          std::size_t m = std::ranges::size(a);
+          std::size_t n = std::ranges::size(b);
+          std::size_t k = std::min(m, n);
+          std::size_t i = detail::first_mismatch(detail::bytes_of(x),
+                                                 detail::bytes_of(y),
+                                                 k * sizeof(T)) / sizeof(T);
+          if (i != k)
+            return O(operator()(x[i], y[i]));
+          return O(operator()(m, n));
+        }
+      }
+      auto i = std::ranges::begin(a);
+      auto j = std::ranges::begin(b);
+      auto ei = std::ranges::end(a);
+      auto ej = std::ranges::end(b);
+      for (; i != ei && j != ej; ++i, ++j) {
+        if (O c = operator()(*i, *j); c != 0)
+          return c;
+      }
+      if (i != ei)
+        return O(std::strong_ordering::greater);
+      if (j != ej)
+        return O(std::strong_ordering::less);
+      return O(std::strong_ordering::equal);
+    }
+
+    // Compare the elements of tuples and pairs in order.
+    template<detail::std_product_type T>
+    constexpr auto compare_tuple(T const& a, T const& b) const
+    {
+      constexpr std::size_t num = std::tuple_size_v<T>;
+      using O = detail::ordering_of_rank<tuple_ordering_rank<T>()>;
+      template for (constexpr std::size_t I : ints(num)) {
+        if (O c = operator()(std::get<I>(a), std::get<I>(b)); c != 0)
+          return c;
+      }
+      return O(std::strong_ordering::equal);
+    }
+
+    // Compare the members of basic data types in order. Uniquely represented,
+    // structurally compared classes first check if their bytes are the same.
+    template<basic_data_type T>
+    constexpr auto compare_data_type(T const& a, T const& b) const
+    {
+      namespace meta = std::experimental::meta;
+      constexpr auto subobjects = meta::subobjects_of(^T, meta::is_data_member);
+      constexpr std::size_t num = size(subobjects);
+      using O = detail::ordering_of_rank<data_type_ordering_rank<T>()>;
+      if constexpr (detail::bitwise_comparable_class<T>) {
+        if (!std::is_constant_evaluated()) {
+          if (std::memcmp(&a, &b, sizeof(T)) == 0)
+            return O(std::strong_ordering::equal);
+        }
+      }
+      template for (constexpr std::size_t I : ints(num)) {
+        constexpr meta::info sub = *std::next(subobjects.begin(), I);
+        if (O c = operator()(a.[:sub:], b.[:sub:]); c != 0)
+          return c;
+      }
+      return O(std::strong_ordering::equal);
+    }
+
+  private:
+    template<typename T>
+    static consteval int ordering_rank_of()
+    {
+      using O = decltype(compare_fn{}(std::declval<T const&>(), std::declval<T const&>()));
+      return detail::ordering_rank<O>;
+    }
+
+    template<typename T>
+    static consteval int tuple_ordering_rank()
+    {
+      int rank = 0;
+      template for (constexpr std::size_t I : ints(std::tuple_size_v<T>))
+        rank = std::max(rank, ordering_rank_of<std::tuple_element_t<I, T>>());
+      return rank;
+    }
+
+    template<typename T>
+    static consteval int data_type_ordering_rank()
+    {
+      namespace meta = std::experimental::meta;
+      constexpr auto subobjects = meta::subobjects_of(^T, meta::is_data_member);
+      int rank = 0;
+      template for (constexpr meta::info sub : subobjects) {
+        using M = std::remove_cv_t<typename [:meta::type_of(sub):]>;
+        rank = std::max(rank, ordering_rank_of<M>());
+      }
+      return rank;
+    }
   };
 
   constexpr compare_fn compare;
 
+  // equal
+
+  struct equal_fn
+  {
+    /// Compare scalars with `==`. Note that 0 and -0 are equal, and NaN is
+    /// not equal to itself.
+    template<typename T>
+      requires std::is_scalar_v<T>
+    constexpr bool operator()(T a, T b) const noexcept
+    {
+      return a == b;
+    }
+
+    /// Compare classes and arrays for equality.
+    ///
+    /// Strings compare their characters. Ranges compare their lengths and
+    /// then their elements, and tuples and basic data types compare their
+    /// elements or members. A class with its own `operator==` is compared
+    /// with that instead. Contiguous ranges of uniquely represented values,
+    /// and uniquely represented classes, are compared with memcmp when
+    /// neither they nor their members have comparison operators of their
+    /// own.
+    template<typename T>
+      requires class_type<T> || std::is_array_v<T>
+    constexpr bool operator()(T const& a, T const& b) const
+    {
+      if constexpr (string_like<T>)
+        return std::string_view(a) == std::string_view(b);
+      else if constexpr (std::ranges::range<T>)
+        return equal_range(a, b);
+      else if constexpr (detail::std_product_type<T>)
+        return equal_tuple(a, b);
+      else if constexpr (std::equality_comparable<T>)
+        return a == b;
+      else // basic_data_type<T>
+        return equal_data_type(a, b);
+    }
+
+    template<std::ranges::range R>
+    constexpr bool equal_range(R const& a, R const& b) const
+    {
+      if constexpr (std::ranges::sized_range<R>) {
+        if (std::ranges::size(a) != std::ranges::size(b))
+          return false;
+      }
+      if constexpr (detail::bitwise_comparable_range<R>) {
+        if (!std::is_constant_evaluated()) {
+          using T = std::ranges::range_value_t<R>;
+          std::size_t n = std::ranges::size(a) * sizeof(T);
+          return n == 0 || std::memcmp(std::ranges::data(a), std::ranges::data(b), n) == 0;
+        }
+      }
+      auto i = std::ranges::begin(a);
+      auto j = std::ranges::begin(b);
+      auto ei = std::ranges::end(a);
+      auto ej = std::ranges::end(b);
+      for (; i != ei && j != ej; ++i, ++j) {
+        if (!operator()(*i, *j))
+          return false;
+      }
+      return i == ei && j == ej;
+    }
+
+    template<detail::std_product_type T>
+    constexpr bool equal_tuple(T const& a, T const& b) const
+    {
+      constexpr std::size_t num = std::tuple_size_v<T>;
+      template for (constexpr std::size_t I : ints(num)) {
+        if (!operator()(std::get<I>(a), std::get<I>(b)))
+          return false;
+      }
+      return true;
+    }
+
+    template<basic_data_type T>
+    constexpr bool equal_data_type(T const& a, T const& b) const
+    {
+      namespace meta = std::experimental::meta;
+      if constexpr (detail::bitwise_comparable_class<T>) {
+        if (!std::is_constant_evaluated())
+          return std::memcmp(&a, &b, sizeof(T)) == 0;
+      }
+      constexpr auto subobjects = meta::subobjects_of(^T, meta::is_data_member);
+      constexpr std::size_t num = size(subobjects);
+      template for (constexpr std::size_t I : ints(num)) {
+        constexpr meta::info sub = *std::next(subobjects.begin(), I);
+        if (!operator()(a.[:sub:], b.[:sub:]))
+          return false;
+      }
+      return true;
+    }
+  };
+
+  constexpr equal_fn equal;
+
+  // equal_to
 
-  // FIXME: The comparison of a and b must yield a strong order for a and
-  // b to be equal. This is kind of weird since that's defined in terms of
-  // an order that's kind of implicit in the type.
-  template<typename T>
-  bool equal(T a, T b) noexcept
+  /// A transparent equality function object, for use with lock3::hash in
+  /// hash tables. Strings and C strings (see string_key) compare equal when
+  /// their contents are equal, matching the way lock3::hash hashes them.
+  /// Objects of the same type are compared with lock3::equal, and other
+  /// operands with `==`.
+  struct equal_to
   {
-    return compare(a, b) == std::strong_ordering::equal;
-  }
+    using is_transparent = void;
+
+    template<typename T, typename U>
+    constexpr bool operator()(T const& a, U const& b) const
+    {
+      if constexpr (string_key<T> && string_key<U>)
+        return string_key_view(a) == string_key_view(b);
+      else if constexpr (std::same_as<T, U>)
+        return equal(a, b);
+      else
+        return a == b;
+    }
+  };
 
 } // namespace lock3
 
@@ -3,6 +3,9 @@
 
 #include "integers.hpp"
 
+#include <algorithm>
+#include <string>
+#include <string_view>
 #include <type_traits>
 #include <tuple>
 #include <experimental/meta>
@@ -195,6 +198,65 @@ namespace lock3
     class_type<T> &&
     detail::no_anonymous_union_subobjects<T>();
 
+  // string like
+
+  namespace detail
+  {
+    template<typename T>
+    constexpr bool is_char_string = false;
+
+    template<typename Alloc>
+    constexpr bool is_char_string<std::basic_string<char, std::char_traits<char>, Alloc>> = true;
+
+    template<>
+    constexpr bool is_char_string<std::string_view> = true;
+
+    template<typename T>
+    constexpr bool is_c_string = false;
+
+    template<>
+    constexpr bool is_c_string<char*> = true;
+
+    template<>
+    constexpr bool is_c_string<char const*> = true;
+
+    template<std::size_t N>
+    constexpr bool is_c_string<char[N]> = true;
+  } // namespace detail
+
+  /// Satisfied if `T` is a character string: a std::string (with any
+  /// allocator) or a std::string_view. Each of these can be viewed as a
+  /// std::string_view of its contents.
+  template<typename T>
+  concept string_like = detail::is_char_string<std::remove_cv_t<T>>;
+
+  /// Satisfied if `T` is a C string: a pointer to, or an array of, char
+  /// holding a null-terminated string (e.g., a literal). Structural
+  /// hashing and comparison treat these as a pointer and as an array of
+  /// chars, respectively; only transparent lookup treats them as strings.
+  template<typename T>
+  concept c_string = detail::is_c_string<std::remove_cv_t<T>>;
+
+  /// Satisfied if `T` is a string or a C string. lock3::hash and
+  /// lock3::equal_to hash and compare these by their contents, so that a
+  /// table of strings can be searched with any of them.
+  template<typename T>
+  concept string_key = string_like<T> || c_string<T>;
+
+  /// Returns a view of the characters of the string key `str`. A null
+  /// pointer is empty, and an array ends at its first null character or at
+  /// its end, whichever comes first.
+  template<string_key T>
+  constexpr std::string_view string_key_view(T const& str) noexcept
+  {
+    if constexpr (std::is_array_v<T>)
+      return std::string_view(str, std::ranges::find(str, '\0') - str);
+    else if constexpr (std::is_pointer_v<T>)
+      return str ? std::string_view(str) : std::string_view();
+    else
+      return std::string_view(str);
+  }
+
   // container
 
   // FIXME: Add a bunch more requirements.
@@ -227,9 +289,10 @@ namespace lock3
   concept back_insertion_sequence =
     container<T> &&
     requires (T& t, container_value_t<T> x) {
-      { t.back() } -> std::same_as<container_value_t<T>>;
+      { t.back() } -> std::same_as<container_value_t<T>&>;
       t.push_back(x);
       t.pop_back();
+      t.clear();
     };
 
 } // namespace lock3
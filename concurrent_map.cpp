@@ -0,0 +1,97 @@
+#include "concurrent_map.hpp"
+#include "game.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using H = lock3::fn1va64_hasher;
+
+constexpr int num_keys = 1 << 16;
+constexpr int ops_per_thread = 1 << 20;
+
+// A globally locked map, for comparison.
+struct locked_map
+{
+  bool visit(game::item const& key, int& out)
+  {
+    std::lock_guard lock(mutex);
+    auto iter = map.find(key);
+    if (iter == map.end())
+      return false;
+    out = iter->second;
+    return true;
+  }
+
+  void insert_or_assign(game::item const& key, int value)
+  {
+    std::lock_guard lock(mutex);
+    map.insert_or_assign(key, value);
+  }
+
+  std::mutex mutex;
+  std::unordered_map<game::item, int, lock3::hash<H>> map;
+};
+
+// Lookups and updates in a 9:1 ratio on uniformly random keys.
+void worker_ops(unsigned seed, auto&& lookup, auto&& update)
+{
+  std::minstd_rand rng(seed);
+  for (int i = 0; i < ops_per_thread; ++i) {
+    game::item key {(int)(rng() % num_keys)};
+    if (i % 10 == 0)
+      update(key, i);
+    else
+      lookup(key);
+  }
+}
+
+// Returns millions of operations per second with `n` threads.
+template<typename F>
+double run(int n, F work)
+{
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < n; ++t)
+    threads.emplace_back(work, t + 1);
+  for (std::thread& t : threads)
+    t.join();
+  std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+  return (double)n * ops_per_thread / secs.count() / 1e6;
+}
+
+int main()
+{
+  lock3::concurrent_map<game::item, int, H> sharded;
+  locked_map global;
+  for (int i = 0; i < num_keys; ++i) {
+    sharded.insert(game::item {i}, i);
+    global.insert_or_assign(game::item {i}, i);
+  }
+
+  std::cout << "Mops/s" << std::setw(10) << "threads"
+            << std::setw(12) << "sharded"
+            << std::setw(12) << "global" << '\n';
+
+  for (int n = 1; n <= 64; n *= 2) {
+    double a = run(n, [&](unsigned seed) {
+      worker_ops(seed,
+        [&](game::item const& k) { sharded.visit(k, [](int) { }); },
+        [&](game::item const& k, int v) { sharded.insert_or_assign(k, v); });
+    });
+    double b = run(n, [&](unsigned seed) {
+      int out;
+      worker_ops(seed,
+        [&](game::item const& k) { global.visit(k, out); },
+        [&](game::item const& k, int v) { global.insert_or_assign(k, v); });
+    });
+    std::cout << std::setw(16) << n << std::fixed << std::setprecision(1)
+              << std::setw(12) << a
+              << std::setw(12) << b << '\n';
+  }
+}
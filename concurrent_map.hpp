@@ -0,0 +1,252 @@
+#ifndef LOCK3_CONCURRENT_MAP_HPP
+#define LOCK3_CONCURRENT_MAP_HPP
+
+#include "flat_map.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+namespace lock3
+{
+  /// A hash map that can be shared between threads.
+  ///
+  /// The map is divided into shards, each a flat_map guarded by its own
+  /// reader-writer lock. A key is hashed once. The high bits of its hash
+  /// code select the shard, and the low bits place it within the shard's
+  /// table, so the two choices are independent. Readers of a shard never
+  /// block each other; writers only block operations on the same shard.
+  ///
+  /// Elements are never exposed by reference outside of a lock. Lookups
+  /// either copy the mapped value or run a callback while the shard is
+  /// locked.
+  template<typename Key,
+           typename T,
+           hash_algorithm H = fn1va64_hasher,
+           typename Eq = lock3::equal_to>
+    requires hashable_with<Key, H>
+  class concurrent_map
+  {
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key const, T>;
+    using size_type = std::size_t;
+    using map_type = flat_map<Key, T, H, Eq>;
+
+    /// Constructs a map with 64 shards.
+    concurrent_map()
+      : concurrent_map(64)
+    {
+    }
+
+    /// Constructs a map with at least `n` shards. The number of shards is
+    /// rounded up to a power of two.
+    explicit concurrent_map(std::size_t n)
+      : shard_bits(std::bit_width(std::bit_ceil(n != 0 ? n : 1)) - 1),
+        shards(std::make_unique<shard[]>(std::size_t(1) << shard_bits))
+    {
+    }
+
+    /// The number of shards.
+    std::size_t shard_count() const noexcept
+    {
+      return std::size_t(1) << shard_bits;
+    }
+
+    /// Returns the number of elements. If other threads are modifying the
+    /// map, the result is only a snapshot of each shard at a slightly
+    /// different time.
+    size_type size() const
+    {
+      size_type n = 0;
+      for (std::size_t i = 0; i != shard_count(); ++i) {
+        std::shared_lock lock(shards[i].mutex);
+        n += shards[i].map.size();
+      }
+      return n;
+    }
+
+    bool empty() const
+    {
+      return size() == 0;
+    }
+
+    // Lookup
+
+    /// Returns true if `key` is in the map.
+    bool contains(Key const& key) const
+    {
+      std::size_t hash = hash_of(key);
+      shard const& s = shard_for(hash);
+      std::shared_lock lock(s.mutex);
+      return s.map.find(key, hash) != s.map.end();
+    }
+
+    /// Returns a copy of the value mapped to `key`, if any.
+    std::optional<T> find(Key const& key) const
+    {
+      std::optional<T> result;
+      visit(key, [&](T const& value) { result = value; });
+      return result;
+    }
+
+    /// Calls `f(value)` with the value mapped to `key` while its shard is
+    /// locked for reading. Returns false if `key` is not in the map.
+    template<typename F>
+    bool visit(Key const& key, F f) const
+    {
+      std::size_t hash = hash_of(key);
+      shard const& s = shard_for(hash);
+      std::shared_lock lock(s.mutex);
+      auto iter = s.map.find(key, hash);
+      if (iter == s.map.end())
+        return false;
+      f(iter->second);
+      return true;
+    }
+
+    // Modifiers
+
+    /// Inserts `key` mapped to `value` unless `key` is already present.
+    /// Returns true if the element was inserted.
+    template<typename V>
+    bool insert(Key const& key, V&& value)
+    {
+      std::size_t hash = hash_of(key);
+      shard& s = shard_for(hash);
+      std::unique_lock lock(s.mutex);
+      return s.map.emplace_key(key, hash,
+                               std::piecewise_construct,
+                               std::forward_as_tuple(key),
+                               std::forward_as_tuple(std::forward<V>(value))).second;
+    }
+
+    /// Maps `key` to `value`, replacing any previous value. Returns true if
+    /// the element was inserted.
+    template<typename V>
+    bool insert_or_assign(Key const& key, V&& value)
+    {
+      std::size_t hash = hash_of(key);
+      shard& s = shard_for(hash);
+      std::unique_lock lock(s.mutex);
+      auto [iter, inserted] =
+        s.map.emplace_key(key, hash,
+                          std::piecewise_construct,
+                          std::forward_as_tuple(key),
+                          std::forward_as_tuple(std::forward<V>(value)));
+      if (!inserted)
+        iter->second = std::forward<V>(value);
+      return inserted;
+    }
+
+    /// Calls `f(value)` with the value mapped to `key` while its shard is
+    /// locked for writing. Returns false if `key` is not in the map.
+    template<typename F>
+    bool update(Key const& key, F f)
+    {
+      std::size_t hash = hash_of(key);
+      shard& s = shard_for(hash);
+      std::unique_lock lock(s.mutex);
+      auto iter = s.map.find(key, hash);
+      if (iter == s.map.end())
+        return false;
+      f(iter->second);
+      return true;
+    }
+
+    /// Removes `key`. Returns true if it was present.
+    bool erase(Key const& key)
+    {
+      std::size_t hash = hash_of(key);
+      shard& s = shard_for(hash);
+      std::unique_lock lock(s.mutex);
+      return s.map.erase(key, hash) != 0;
+    }
+
+    void clear()
+    {
+      for (std::size_t i = 0; i != shard_count(); ++i) {
+        std::unique_lock lock(shards[i].mutex);
+        shards[i].map.clear();
+      }
+    }
+
+    // Iteration
+
+    /// Calls `f(key, value)` for each element. Each shard is locked for
+    /// reading while it is visited, so the elements of one shard are seen
+    /// consistently, but different shards may be seen at different times.
+    /// `f` must not modify the map.
+    template<typename F>
+    void for_each(F f) const
+    {
+      for (std::size_t i = 0; i != shard_count(); ++i) {
+        std::shared_lock lock(shards[i].mutex);
+        for (value_type const& v : shards[i].map)
+          f(v.first, v.second);
+      }
+    }
+
+    /// Returns a copy of the elements, taken one shard at a time (see
+    /// for_each).
+    std::vector<std::pair<Key, T>> snapshot() const
+    {
+      std::vector<std::pair<Key, T>> result;
+      for (std::size_t i = 0; i != shard_count(); ++i) {
+        std::shared_lock lock(shards[i].mutex);
+        result.insert(result.end(), shards[i].map.begin(), shards[i].map.end());
+      }
+      return result;
+    }
+
+  private:
+    // Each shard is aligned to its own cache line so that locking one
+    // shard does not invalidate its neighbors.
+    struct alignas(64) shard
+    {
+      mutable std::shared_mutex mutex;
+      map_type map;
+    };
+
+    std::size_t hash_of(Key const& key) const noexcept
+    {
+      return static_cast<std::size_t>(lock3::hash<H>{}(key));
+    }
+
+    // Select a shard using the high bits of the hash code.
+    std::size_t shard_index(std::size_t hash) const noexcept
+    {
+      constexpr int digits = std::numeric_limits<hash_result_t<H>>::digits;
+      if (shard_bits == 0)
+        return 0;
+      return (hash >> (digits - shard_bits)) & (shard_count() - 1);
+    }
+
+    shard& shard_for(std::size_t hash) noexcept
+    {
+      return shards[shard_index(hash)];
+    }
+
+    shard const& shard_for(std::size_t hash) const noexcept
+    {
+      return shards[shard_index(hash)];
+    }
+
+    /// The base-2 logarithm of the number of shards.
+    int shard_bits;
+
+    /// The shards.
+    std::unique_ptr<shard[]> shards;
+  };
+
+} // namespace lock3
+
+#endif
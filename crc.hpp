@@ -0,0 +1,211 @@
+#ifndef LOCK3_CRC_HPP
+#define LOCK3_CRC_HPP
+
+#include "hash.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#  include <nmmintrin.h>
+#  define LOCK3_CRC32C_SSE42 1
+#endif
+
+namespace lock3
+{
+  namespace detail
+  {
+    // The reflected Castagnoli polynomial.
+    constexpr std::uint32_t crc32c_poly = 0x82F63B78u;
+
+    // Advance the raw CRC register `crc` over one byte, one bit at a time.
+    // This is only used to build tables.
+    constexpr std::uint32_t crc32c_bitwise(std::uint32_t crc, unsigned char b)
+    {
+      crc ^= b;
+      for (int k = 0; k < 8; ++k)
+        crc = (crc >> 1) ^ (crc32c_poly & (0u - (crc & 1u)));
+      return crc;
+    }
+
+    // Slicing-by-8 tables for the portable kernel. Table `k` advances a
+    // byte through `k` additional zero bytes.
+    constexpr auto crc32c_tables = []() {
+      std::array<std::array<std::uint32_t, 256>, 8> t {};
+      for (std::uint32_t i = 0; i < 256; ++i)
+        t[0][i] = crc32c_bitwise(0, i);
+      for (std::size_t k = 1; k < 8; ++k)
+        for (std::uint32_t i = 0; i < 256; ++i)
+          t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+      return t;
+    }();
+
+    inline std::uint64_t crc32c_load64(unsigned char const* p) noexcept
+    {
+      std::uint64_t x;
+      std::memcpy(&x, p, sizeof(x));
+      if constexpr (std::endian::native == std::endian::big)
+        x = __builtin_bswap64(x);
+      return x;
+    }
+
+    // The portable kernel: slicing-by-8.
+    inline std::uint32_t
+    crc32c_portable(std::uint32_t crc, unsigned char const* p, std::size_t n) noexcept
+    {
+      auto const& t = crc32c_tables;
+      for (; n >= 8; n -= 8, p += 8) {
+        std::uint64_t x = crc32c_load64(p) ^ crc;
+        crc = t[7][x & 0xff] ^ t[6][(x >> 8) & 0xff] ^
+              t[5][(x >> 16) & 0xff] ^ t[4][(x >> 24) & 0xff] ^
+              t[3][(x >> 32) & 0xff] ^ t[2][(x >> 40) & 0xff] ^
+              t[1][(x >> 48) & 0xff] ^ t[0][x >> 56];
+      }
+      for (; n != 0; --n, ++p)
+        crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+      return crc;
+    }
+
+#if defined(LOCK3_CRC32C_SSE42)
+    // The number of bytes given to each of the three interleaved streams
+    // in the SSE4.2 kernel.
+    constexpr std::size_t crc32c_lane_size = 256;
+
+    // Tables that advance a raw CRC register over `crc32c_lane_size` zero
+    // bytes. Because the register is linear, a CRC over `A || B` is the CRC
+    // over `A` shifted past `B`, xor'd with the CRC over `B` starting from
+    // zero. That lets us compute independent streams and then stitch them
+    // back together.
+    constexpr auto crc32c_shift_tables = []() {
+      // The image of each bit of the register.
+      std::array<std::uint32_t, 32> basis {};
+      for (int i = 0; i < 32; ++i) {
+        std::uint32_t crc = 1u << i;
+        for (std::size_t k = 0; k < crc32c_lane_size; ++k)
+          crc = (crc >> 8) ^ crc32c_tables[0][crc & 0xff];
+        basis[i] = crc;
+      }
+      std::array<std::array<std::uint32_t, 256>, 4> t {};
+      for (int k = 0; k < 4; ++k) {
+        for (std::uint32_t b = 0; b < 256; ++b) {
+          std::uint32_t crc = 0;
+          for (int i = 0; i < 8; ++i)
+            if (b & (1u << i))
+              crc ^= basis[8 * k + i];
+          t[k][b] = crc;
+        }
+      }
+      return t;
+    }();
+
+    inline std::uint32_t crc32c_shift(std::uint32_t crc) noexcept
+    {
+      auto const& t = crc32c_shift_tables;
+      return t[0][crc & 0xff] ^ t[1][(crc >> 8) & 0xff] ^
+             t[2][(crc >> 16) & 0xff] ^ t[3][crc >> 24];
+    }
+
+    // The hardware kernel. The crc32 instruction has a latency of three
+    // cycles but a throughput of one, so long inputs are split into three
+    // independent streams to keep the unit busy.
+    __attribute__((target("sse4.2")))
+    inline std::uint32_t
+    crc32c_sse42(std::uint32_t crc, unsigned char const* p, std::size_t n) noexcept
+    {
+      constexpr std::size_t lane = crc32c_lane_size;
+      while (n >= 3 * lane) {
+        std::uint64_t c0 = crc, c1 = 0, c2 = 0;
+        for (std::size_t i = 0; i < lane; i += 8) {
+          c0 = _mm_crc32_u64(c0, crc32c_load64(p + i));
+          c1 = _mm_crc32_u64(c1, crc32c_load64(p + lane + i));
+          c2 = _mm_crc32_u64(c2, crc32c_load64(p + 2 * lane + i));
+        }
+        crc = crc32c_shift(crc32c_shift(std::uint32_t(c0)) ^ std::uint32_t(c1)) ^
+              std::uint32_t(c2);
+        p += 3 * lane;
+        n -= 3 * lane;
+      }
+
+      std::uint64_t c = crc;
+      for (; n >= 8; n -= 8, p += 8)
+        c = _mm_crc32_u64(c, crc32c_load64(p));
+      crc = std::uint32_t(c);
+      for (; n != 0; --n, ++p)
+        crc = _mm_crc32_u8(crc, *p);
+      return crc;
+    }
+#endif
+
+    // A CRC32C kernel updates the raw register (i.e., without the initial
+    // and final inversion) over `n` bytes.
+    using crc32c_kernel =
+      std::uint32_t (*)(std::uint32_t, unsigned char const*, std::size_t) noexcept;
+
+    // Returns the best kernel supported by the executing CPU.
+    inline crc32c_kernel select_crc32c_kernel() noexcept
+    {
+#if defined(LOCK3_CRC32C_SSE42)
+      if (__builtin_cpu_supports("sse4.2"))
+        return crc32c_sse42;
+#endif
+      return crc32c_portable;
+    }
+
+    // Returns the kernel for this CPU. The CPU is queried once, the first time
+    // this is called, so hashers used during static initialization are safe.
+    inline crc32c_kernel crc32c_dispatch() noexcept
+    {
+      static crc32c_kernel const kernel = select_crc32c_kernel();
+      return kernel;
+    }
+
+  } // namespace detail
+
+  /// The CRC32C (Castagnoli) checksum as a hash algorithm.
+  ///
+  /// On x86-64 processors with SSE4.2, this uses the crc32 instruction.
+  /// Otherwise, it falls back to a portable table-driven kernel. The kernel
+  /// is selected at run time, and every kernel computes exactly the same
+  /// result, so digests are stable across machines.
+  ///
+  /// NOTE: CRCs are linear, so they make good checksums but only fair hash
+  /// codes. Prefer xxh64_hasher when collision resistance against structured
+  /// keys matters.
+  struct crc32c_hasher
+  {
+    using result_type = std::uint32_t;
+
+    /// The kernels consume 8 bytes per step, and each call goes through
+    /// a function pointer, so small appends are worth buffering.
+    static constexpr std::size_t block_size = 8;
+
+    crc32c_hasher()
+      : kernel(detail::crc32c_dispatch())
+    {
+    }
+
+    /// Hash bytes into the checksum.
+    void operator()(const void* p, std::size_t n) noexcept
+    {
+      crc = kernel(crc, static_cast<unsigned char const*>(p), n);
+    }
+
+    /// Converts to the computed checksum.
+    explicit operator result_type() const noexcept
+    {
+      return ~crc;
+    }
+
+    /// The selected kernel.
+    detail::crc32c_kernel kernel;
+
+    /// The raw CRC register.
+    std::uint32_t crc = ~0u;
+  };
+
+} // namespace lock3
+
+#endif
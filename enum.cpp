@@ -0,0 +1,34 @@
+#include "enum.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+enum class opcode { hello, ping, pong, get, put, erase, bye };
+
+// Sparse values are looked up by binary search.
+enum status : int { ok = 200, created = 201, moved = 301, not_found = 404, error = 500 };
+
+// Aliases are named by the first enumerator declared.
+enum class level { debug, info, warning, warn = warning, error };
+
+int main()
+{
+  using namespace lock3;
+
+  for (opcode op : {opcode::hello, opcode::get, opcode::bye}) {
+    std::cout << to_string(op) << '\n';
+    assert(from_string<opcode>(to_string(op)) == op);
+  }
+  assert(std::strcmp(to_string(opcode(42)), "<unknown>") == 0);
+  assert(!from_string<opcode>("hell"));
+
+  assert(std::strcmp(to_string(not_found), "not_found") == 0);
+  assert(std::strcmp(to_string(status(302)), "<unknown>") == 0);
+  assert(from_string<status>("moved") == moved);
+
+  assert(std::strcmp(to_string(level::warn), "warning") == 0);
+  assert(from_string<level>("warn") == level::warning);
+
+  static_assert(from_string<opcode>("put") == opcode::put);
+}
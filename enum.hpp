@@ -2,21 +2,182 @@
 #define LOCK3_ENUM_HPP
 
 #include "concepts.hpp"
+#include "perfect_hash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 #include <experimental/meta>
 
 namespace lock3
 {
-  /// Returns the string representation of `e`.
+  namespace detail
+  {
+    // The enumerators of `T`, in declaration order.
+    template<enumeral T>
+    struct enumerators
+    {
+      static constexpr std::size_t count = [] {
+        namespace meta = std::experimental::meta;
+        return size(meta::members_of(^T));
+      }();
+
+      static constexpr std::array<T, count> values = [] {
+        namespace meta = std::experimental::meta;
+        std::array<T, count> result {};
+        std::size_t i = 0;
+        template for (constexpr meta::info e : meta::members_of(^T))
+          result[i++] = [:e:];
+        return result;
+      }();
+
+      static constexpr std::array<char const*, count> names = [] {
+        namespace meta = std::experimental::meta;
+        std::array<char const*, count> result {};
+        std::size_t i = 0;
+        template for (constexpr meta::info e : meta::members_of(^T))
+          result[i++] = meta::name_of(e);
+        return result;
+      }();
+    };
+
+    // Maps the values of `T` to their names.
+    //
+    // When the values are dense (the common case of enumerators numbered
+    // from some start without large gaps), names are stored in a table
+    // indexed by the value minus the smallest value. Otherwise, the distinct
+    // values are sorted and searched. When several enumerators have the same
+    // value, the first one declared names it.
+    template<enumeral T>
+    struct enum_names
+    {
+      using U = std::underlying_type_t<T>;
+      using E = enumerators<T>;
+
+      static constexpr U min = [] {
+        U result {};
+        for (std::size_t i = 0; i != E::count; ++i)
+          if (i == 0 || U(E::values[i]) < result)
+            result = U(E::values[i]);
+        return result;
+      }();
+
+      static constexpr U max = [] {
+        U result {};
+        for (std::size_t i = 0; i != E::count; ++i)
+          if (i == 0 || U(E::values[i]) > result)
+            result = U(E::values[i]);
+        return result;
+      }();
+
+      // The distance between the smallest and largest values, computed
+      // without overflow.
+      static constexpr auto span =
+        std::make_unsigned_t<U>(max) - std::make_unsigned_t<U>(min);
+
+      // Use a dense table when at least about half of its entries are used.
+      static constexpr bool dense = E::count != 0 && span < 2 * E::count + 8;
+
+      static constexpr auto table = [] {
+        std::array<char const*, dense ? std::size_t(span) + 1 : 0> result {};
+        if constexpr (dense) {
+          for (std::size_t i = E::count; i-- != 0; )
+            result[std::make_unsigned_t<U>(U(E::values[i])) -
+                   std::make_unsigned_t<U>(min)] = E::names[i];
+        }
+        return result;
+      }();
+
+      // The number of distinct values.
+      static constexpr std::size_t distinct = [] {
+        std::array<U, E::count> sorted {};
+        for (std::size_t i = 0; i != E::count; ++i)
+          sorted[i] = U(E::values[i]);
+        std::sort(sorted.begin(), sorted.end());
+        return std::size_t(std::unique(sorted.begin(), sorted.end()) - sorted.begin());
+      }();
+
+      static constexpr auto sorted = [] {
+        std::array<std::pair<U, char const*>, dense ? 0 : distinct> result {};
+        if constexpr (!dense) {
+          // Sort by value, then by declaration order, so that the first
+          // enumerator declared survives std::unique.
+          std::array<std::pair<U, std::size_t>, E::count> all {};
+          for (std::size_t i = 0; i != E::count; ++i)
+            all[i] = {U(E::values[i]), i};
+          std::sort(all.begin(), all.end());
+          auto last = std::unique(all.begin(), all.end(), [](auto const& a, auto const& b) {
+            return a.first == b.first;
+          });
+          for (auto iter = all.begin(); iter != last; ++iter)
+            result[iter - all.begin()] = {iter->first, E::names[iter->second]};
+        }
+        return result;
+      }();
+
+      static constexpr char const* lookup(T value) noexcept
+      {
+        U u = U(value);
+        if constexpr (dense) {
+          auto offset = std::make_unsigned_t<U>(u) - std::make_unsigned_t<U>(min);
+          if (u < min || u > max)
+            return nullptr;
+          return table[offset];
+        }
+        else {
+          auto iter = std::lower_bound(sorted.begin(), sorted.end(), u,
+                                       [](auto const& a, U b) { return a.first < b; });
+          if (iter == sorted.end() || iter->first != u)
+            return nullptr;
+          return iter->second;
+        }
+      }
+    };
+
+    // A perfect hash table over the names of the enumerators of `T`.
+    template<enumeral T>
+    struct enum_values
+    {
+      using E = enumerators<T>;
+
+      static constexpr perfect_hash<E::count> table = [] {
+        std::array<std::string_view, E::count> keys {};
+        for (std::size_t i = 0; i != E::count; ++i)
+          keys[i] = E::names[i];
+        return perfect_hash<E::count>(keys);
+      }();
+    };
+  } // namespace detail
+
+  /// Returns the name of the enumerator whose value is `value`, or
+  /// "<unknown>" if there is none. This takes constant time for enums whose
+  /// values are dense and logarithmic time otherwise.
   template<enumeral T>
-  char const* to_string(T value)
+  constexpr char const* to_string(T value)
   {
-    template for (constexpr meta::info e : meta::members_of(^T))
-      if (e == value)
-        return meta::name_of(e);
+    if (char const* name = detail::enum_names<T>::lookup(value))
+      return name;
     return "<unknown>";
   }
 
+  /// Returns the enumerator of `T` named `name`, if any. Lookup uses a
+  /// perfect hash table built at compile time, so it takes constant time
+  /// regardless of the number of enumerators.
+  template<enumeral T>
+  constexpr std::optional<T> from_string(std::string_view name)
+  {
+    using E = detail::enumerators<T>;
+    std::size_t index = detail::enum_values<T>::table.find(name);
+    if (index == perfect_hash<E::count>::npos)
+      return std::nullopt;
+    return E::values[index];
+  }
+
 } // namespace lock3
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,143 @@
+#include "flat_map.hpp"
+#include "compare.hpp"
+#include "game.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Runs `f` and returns the average number of nanoseconds per operation.
+template<typename F>
+double time_per_op(std::size_t ops, F f)
+{
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto stop = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::nano> ns = stop - start;
+  return ns.count() / ops;
+}
+
+// Benchmark insert, successful and failed lookup, and erase.
+template<typename Map, typename Key>
+void bench(char const* name, std::vector<Key> const& keys, std::vector<Key> const& misses)
+{
+  Map map;
+  std::size_t found = 0;
+
+  double insert = time_per_op(keys.size(), [&] {
+    for (Key const& k : keys)
+      map.emplace(k, 1);
+  });
+
+  double hit = time_per_op(keys.size(), [&] {
+    for (Key const& k : keys)
+      found += map.find(k) != map.end();
+  });
+
+  double miss = time_per_op(misses.size(), [&] {
+    for (Key const& k : misses)
+      found += map.find(k) != map.end();
+  });
+
+  double erase = time_per_op(keys.size(), [&] {
+    for (Key const& k : keys)
+      map.erase(k);
+  });
+
+  std::cout << std::left << std::setw(24) << name << std::right << std::fixed
+            << std::setprecision(1)
+            << std::setw(10) << insert
+            << std::setw(10) << hit
+            << std::setw(10) << miss
+            << std::setw(10) << erase
+            << (found == keys.size() ? "" : "  (wrong!)") << '\n';
+}
+
+// Adapts flat_map to the interface used by bench().
+template<typename Key, typename T, typename H>
+struct flat_map_adaptor : lock3::flat_map<Key, T, H>
+{
+  template<typename V>
+  auto emplace(Key const& k, V&& v)
+  {
+    return this->try_emplace(k, std::forward<V>(v));
+  }
+};
+
+// Looks up string keys arriving as string_views, as when parsing a network
+// buffer: by constructing a std::string for each probe, and by heterogeneous
+// lookup.
+void bench_string_views(std::size_t n)
+{
+  using map_type = lock3::flat_map<std::string, int, lock3::fn1va64_hasher, lock3::equal_to>;
+  map_type map;
+  std::string buf;
+  std::vector<std::pair<std::size_t, std::size_t>> spans;
+  for (std::size_t i = 0; i < n; ++i) {
+    std::string key = "player-" + std::to_string(i * 7919);
+    map.try_emplace(key, 1);
+    spans.push_back({buf.size(), key.size()});
+    buf += key;
+  }
+
+  std::size_t found = 0;
+  double copy = time_per_op(n, [&] {
+    for (auto [pos, len] : spans)
+      found += map.find(std::string(buf.data() + pos, len)) != map.end();
+  });
+  double view = time_per_op(n, [&] {
+    for (auto [pos, len] : spans)
+      found += map.find(std::string_view(buf.data() + pos, len)) != map.end();
+  });
+
+  std::cout << std::left << std::setw(24) << "flat_map<string> hit" << std::right
+            << std::fixed << std::setprecision(1)
+            << std::setw(10) << copy << " (string)"
+            << std::setw(10) << view << " (string_view)"
+            << (found == 2 * n ? "" : "  (wrong!)") << '\n';
+}
+
+int main()
+{
+  using H = lock3::fn1va64_hasher;
+  constexpr std::size_t n = 1 << 20;
+
+  std::mt19937_64 rng(42);
+  std::vector<int> ints(n);
+  std::vector<int> int_misses(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    // Even keys below 2^31 hit and odd ones miss, without overflowing.
+    ints[i] = (int)(rng() >> 34) * 2;
+    int_misses[i] = ints[i] + 1;
+  }
+
+  std::vector<game::item> items(n);
+  std::vector<game::item> item_misses(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    items[i].id = ints[i];
+    item_misses[i].id = int_misses[i];
+  }
+
+  std::cout << "ns/op (" << n << " keys)"
+            << std::setw(10) << "insert"
+            << std::setw(10) << "hit"
+            << std::setw(10) << "miss"
+            << std::setw(10) << "erase" << '\n';
+
+  bench<std::unordered_map<int, int, lock3::hash<H>>>(
+    "unordered_map<int>", ints, int_misses);
+  bench<flat_map_adaptor<int, int, H>>(
+    "flat_map<int>", ints, int_misses);
+
+  bench<std::unordered_map<game::item, int, lock3::hash<H>>>(
+    "unordered_map<item>", items, item_misses);
+  bench<flat_map_adaptor<game::item, int, H>>(
+    "flat_map<item>", items, item_misses);
+
+  bench_string_views(n);
+}
@@ -0,0 +1,733 @@
+#ifndef LOCK3_FLAT_MAP_HPP
+#define LOCK3_FLAT_MAP_HPP
+
+#include "compare.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+namespace lock3
+{
+  namespace detail
+  {
+    // Each slot of a flat table has a control byte. A full slot stores the
+    // low 7 bits of its element's hash code, so most probes can reject a
+    // slot without comparing keys. Empty and deleted slots have the high
+    // bit set.
+    using ctrl_t = signed char;
+
+    constexpr ctrl_t ctrl_empty = -128;
+    constexpr ctrl_t ctrl_deleted = -2;
+
+    // The number of control bytes examined at once.
+    constexpr std::size_t group_size = 16;
+
+    // A bit mask over the slots of a group.
+    using group_mask = std::uint32_t;
+
+    // Returns the slots in the group at `g` whose control byte is `c`.
+    inline group_mask match_ctrl(ctrl_t const* g, ctrl_t c) noexcept
+    {
+#if defined(__SSE2__)
+      __m128i bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(g));
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)));
+#else
+      group_mask m = 0;
+      for (std::size_t i = 0; i != group_size; ++i)
+        m |= group_mask(g[i] == c) << i;
+      return m;
+#endif
+    }
+
+    // Returns the slots in the group at `g` that are empty or deleted.
+    inline group_mask match_free(ctrl_t const* g) noexcept
+    {
+#if defined(__SSE2__)
+      __m128i bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(g));
+      return _mm_movemask_epi8(bytes);
+#else
+      group_mask m = 0;
+      for (std::size_t i = 0; i != group_size; ++i)
+        m |= group_mask(g[i] < 0) << i;
+      return m;
+#endif
+    }
+
+    // Returns the index of the lowest slot in `m`.
+    inline std::size_t first_slot(group_mask m) noexcept
+    {
+      return std::countr_zero(m);
+    }
+
+    // Satisfied if a table can be searched with keys of other types.
+    template<typename Hash, typename Eq>
+    concept transparent_lookup =
+      requires {
+        typename Hash::is_transparent;
+        typename Eq::is_transparent;
+      };
+
+    // An open addressing hash table in the style of Abseil's "Swiss tables".
+    //
+    // Slots are divided into groups of 16 with one control byte per slot.
+    // A lookup hashes the key once, then probes whole groups, comparing all
+    // 16 control bytes with the key's 7-bit tag in one SIMD operation. Only
+    // slots whose tag matches have their keys compared. The search stops at
+    // the first group with an empty slot.
+    //
+    // The `Policy` describes how elements are stored:
+    //
+    //    typename Policy::key_type;
+    //    typename Policy::value_type;
+    //    Policy::key(value) -> key_type const&;
+    //    Policy::mutable_values -> bool; // false if elements are keys
+    //
+    // The table is kept at most 7/8 full, counting deleted slots.
+    template<typename Policy, hash_algorithm H, typename Eq>
+    class flat_table
+    {
+    public:
+      using key_type = typename Policy::key_type;
+      using value_type = typename Policy::value_type;
+      using size_type = std::size_t;
+      using difference_type = std::ptrdiff_t;
+      using hasher = lock3::hash<H>;
+      using key_equal = Eq;
+      using reference = value_type&;
+      using const_reference = value_type const&;
+
+      template<bool Const>
+      class basic_iterator
+      {
+      public:
+        using value_type = typename Policy::value_type;
+        using reference = std::conditional_t<Const, value_type const&, value_type&>;
+        using pointer = std::conditional_t<Const, value_type const*, value_type*>;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        basic_iterator() = default;
+
+        basic_iterator(ctrl_t const* ctrl, value_type* slot, ctrl_t const* limit)
+          : ctrl(ctrl), slot(slot), limit(limit)
+        {
+          skip_free();
+        }
+
+        /// Converts a mutable iterator to a const iterator.
+        operator basic_iterator<true>() const
+          requires (!Const)
+        {
+          return basic_iterator<true>(ctrl, slot, limit);
+        }
+
+        reference operator*() const
+        {
+          return *slot;
+        }
+
+        pointer operator->() const
+        {
+          return slot;
+        }
+
+        basic_iterator& operator++()
+        {
+          ++ctrl;
+          ++slot;
+          skip_free();
+          return *this;
+        }
+
+        basic_iterator operator++(int)
+        {
+          basic_iterator tmp = *this;
+          ++*this;
+          return tmp;
+        }
+
+        friend bool operator==(basic_iterator a, basic_iterator b)
+        {
+          return a.ctrl == b.ctrl;
+        }
+
+      private:
+        friend class flat_table;
+
+        // Advance past empty and deleted slots.
+        void skip_free()
+        {
+          while (ctrl != limit && *ctrl < 0) {
+            ++ctrl;
+            ++slot;
+          }
+        }
+
+        ctrl_t const* ctrl = nullptr;
+        value_type* slot = nullptr;
+        ctrl_t const* limit = nullptr;
+      };
+
+      using iterator = basic_iterator<!Policy::mutable_values>;
+      using const_iterator = basic_iterator<true>;
+
+      flat_table() = default;
+
+      flat_table(flat_table const& x)
+      {
+        reserve(x.size());
+        for (value_type const& v : x)
+          insert_unique(hash_of(Policy::key(v)), v);
+      }
+
+      flat_table(flat_table&& x) noexcept
+        : ctrl(std::exchange(x.ctrl, nullptr)),
+          slots(std::exchange(x.slots, nullptr)),
+          groups(std::exchange(x.groups, 0)),
+          used(std::exchange(x.used, 0)),
+          growth_left(std::exchange(x.growth_left, 0))
+      {
+      }
+
+      flat_table& operator=(flat_table x) noexcept
+      {
+        swap(x);
+        return *this;
+      }
+
+      ~flat_table()
+      {
+        destroy();
+      }
+
+      void swap(flat_table& x) noexcept
+      {
+        std::swap(ctrl, x.ctrl);
+        std::swap(slots, x.slots);
+        std::swap(groups, x.groups);
+        std::swap(used, x.used);
+        std::swap(growth_left, x.growth_left);
+      }
+
+      // Iterators
+
+      iterator begin() noexcept
+      {
+        return iterator(ctrl, slots, ctrl + capacity());
+      }
+
+      iterator end() noexcept
+      {
+        return iterator(ctrl + capacity(), slots + capacity(), ctrl + capacity());
+      }
+
+      const_iterator begin() const noexcept
+      {
+        return const_iterator(ctrl, slots, ctrl + capacity());
+      }
+
+      const_iterator end() const noexcept
+      {
+        return const_iterator(ctrl + capacity(), slots + capacity(), ctrl + capacity());
+      }
+
+      // Capacity
+
+      bool empty() const noexcept
+      {
+        return used == 0;
+      }
+
+      size_type size() const noexcept
+      {
+        return used;
+      }
+
+      /// The number of slots.
+      size_type capacity() const noexcept
+      {
+        return groups * group_size;
+      }
+
+      /// Ensure that `n` elements can be stored without rehashing.
+      void reserve(size_type n)
+      {
+        size_type want = 1;
+        while (want * group_size * 7 / 8 < n)
+          want *= 2;
+        if (want > groups)
+          rehash(want);
+      }
+
+      /// Removes all elements, keeping the storage.
+      void clear() noexcept
+      {
+        for (std::size_t i = 0; i != capacity(); ++i) {
+          if (ctrl[i] >= 0)
+            std::destroy_at(slots + i);
+          ctrl[i] = ctrl_empty;
+        }
+        used = 0;
+        growth_left = max_load();
+      }
+
+      // Lookup
+
+      /// Returns the hash code used to place `key`.
+      template<typename K>
+      std::size_t hash_of(K const& key) const noexcept
+      {
+        return static_cast<std::size_t>(hasher{}(key));
+      }
+
+      iterator find(key_type const& key) noexcept
+      {
+        return find(key, hash_of(key));
+      }
+
+      const_iterator find(key_type const& key) const noexcept
+      {
+        return find(key, hash_of(key));
+      }
+
+      /// Find `key` using a hash code already computed by hash_of().
+      iterator find(key_type const& key, std::size_t hash) noexcept
+      {
+        std::size_t i = find_index(key, hash);
+        return i == npos ? end() : iterator_at(i);
+      }
+
+      const_iterator find(key_type const& key, std::size_t hash) const noexcept
+      {
+        std::size_t i = find_index(key, hash);
+        return i == npos ? end() : const_iterator(ctrl + i, slots + i, ctrl + capacity());
+      }
+
+      bool contains(key_type const& key) const noexcept
+      {
+        return find_index(key, hash_of(key)) != npos;
+      }
+
+      size_type count(key_type const& key) const noexcept
+      {
+        return contains(key) ? 1 : 0;
+      }
+
+      /// Heterogeneous lookup. These are available when both the hash and
+      /// `Eq` are transparent (e.g., lock3::equal_to), and allow finding a
+      /// std::string key with a string_view or C string, for example.
+      template<typename K>
+        requires transparent_lookup<hasher, Eq>
+      iterator find(K const& key) noexcept
+      {
+        decltype(auto) k = lookup_key(key);
+        std::size_t i = find_index(k, hash_of(k));
+        return i == npos ? end() : iterator_at(i);
+      }
+
+      template<typename K>
+        requires transparent_lookup<hasher, Eq>
+      const_iterator find(K const& key) const noexcept
+      {
+        decltype(auto) k = lookup_key(key);
+        std::size_t i = find_index(k, hash_of(k));
+        return i == npos ? end() : const_iterator(ctrl + i, slots + i, ctrl + capacity());
+      }
+
+      template<typename K>
+        requires transparent_lookup<hasher, Eq>
+      bool contains(K const& key) const noexcept
+      {
+        decltype(auto) k = lookup_key(key);
+        return find_index(k, hash_of(k)) != npos;
+      }
+
+      template<typename K>
+        requires transparent_lookup<hasher, Eq>
+      size_type count(K const& key) const noexcept
+      {
+        return contains(key) ? 1 : 0;
+      }
+
+      // Modifiers
+
+      /// Inserts an element constructed from `args` unless `key` is present.
+      template<typename... Args>
+      std::pair<iterator, bool>
+      emplace_key(key_type const& key, std::size_t hash, Args&&... args)
+      {
+        std::size_t i = find_index(key, hash);
+        if (i != npos)
+          return {iterator_at(i), false};
+        i = insert_unique(hash, std::forward<Args>(args)...);
+        return {iterator_at(i), true};
+      }
+
+      template<typename... Args>
+      std::pair<iterator, bool> emplace_key(key_type const& key, Args&&... args)
+      {
+        return emplace_key(key, hash_of(key), std::forward<Args>(args)...);
+      }
+
+      /// Removes the element at `pos`.
+      void erase(const_iterator pos) noexcept
+      {
+        erase_index(pos.ctrl - ctrl);
+      }
+
+      /// Removes the element with `key`, returning the number removed.
+      size_type erase(key_type const& key) noexcept
+      {
+        return erase(key, hash_of(key));
+      }
+
+      size_type erase(key_type const& key, std::size_t hash) noexcept
+      {
+        std::size_t i = find_index(key, hash);
+        if (i == npos)
+          return 0;
+        erase_index(i);
+        return 1;
+      }
+
+    private:
+      static constexpr std::size_t npos = -1;
+
+      // The number of elements (and tombstones) allowed before growing.
+      std::size_t max_load() const noexcept
+      {
+        return capacity() * 7 / 8;
+      }
+
+      // The 7-bit tag stored in the control byte.
+      static ctrl_t tag_of(std::size_t hash) noexcept
+      {
+        return static_cast<ctrl_t>(hash & 0x7f);
+      }
+
+      // The first group probed.
+      std::size_t group_of(std::size_t hash) const noexcept
+      {
+        return (hash >> 7) & (groups - 1);
+      }
+
+      iterator iterator_at(std::size_t i) noexcept
+      {
+        return iterator(ctrl + i, slots + i, ctrl + capacity());
+      }
+
+      // Returns the key to look up for `key`. A C string is viewed once, so
+      // that its length is not recomputed by every key comparison.
+      template<typename K>
+      static decltype(auto) lookup_key(K const& key) noexcept
+      {
+        if constexpr (string_like<key_type> && c_string<K>)
+          return string_key_view(key);
+        else
+          return (key);
+      }
+
+      // Returns the index of the element with `key`, or npos.
+      //
+      // Groups are probed in triangular order, which visits every group
+      // when the number of groups is a power of two.
+      template<typename K>
+      std::size_t find_index(K const& key, std::size_t hash) const noexcept
+      {
+        if (groups == 0)
+          return npos;
+        ctrl_t tag = tag_of(hash);
+        std::size_t g = group_of(hash);
+        for (std::size_t step = 1; ; ++step) {
+          ctrl_t const* c = ctrl + g * group_size;
+          for (group_mask m = match_ctrl(c, tag); m != 0; m &= m - 1) {
+            std::size_t i = g * group_size + first_slot(m);
+            if (Eq{}(Policy::key(slots[i]), key))
+              return i;
+          }
+          if (match_ctrl(c, ctrl_empty) != 0)
+            return npos;
+          g = (g + step) & (groups - 1);
+        }
+      }
+
+      // Returns the first free slot on the probe sequence for `hash`.
+      std::size_t find_free(std::size_t hash) const noexcept
+      {
+        std::size_t g = group_of(hash);
+        for (std::size_t step = 1; ; ++step) {
+          ctrl_t const* c = ctrl + g * group_size;
+          if (group_mask m = match_free(c))
+            return g * group_size + first_slot(m);
+          g = (g + step) & (groups - 1);
+        }
+      }
+
+      // Constructs a new element for a key known not to be present.
+      template<typename... Args>
+      std::size_t insert_unique(std::size_t hash, Args&&... args)
+      {
+        if (growth_left == 0)
+          grow();
+        std::size_t i = find_free(hash);
+        std::construct_at(slots + i, std::forward<Args>(args)...);
+        if (ctrl[i] == ctrl_empty)
+          --growth_left;
+        ctrl[i] = tag_of(hash);
+        ++used;
+        return i;
+      }
+
+      void erase_index(std::size_t i) noexcept
+      {
+        std::destroy_at(slots + i);
+        --used;
+
+        // If this group has an empty slot, no probe ever continued past it,
+        // so the slot can be made empty again. Otherwise, leave a tombstone
+        // so that probes continue past it.
+        ctrl_t const* g = ctrl + (i - i % group_size);
+        if (match_ctrl(g, ctrl_empty) != 0) {
+          ctrl[i] = ctrl_empty;
+          ++growth_left;
+        }
+        else {
+          ctrl[i] = ctrl_deleted;
+        }
+      }
+
+      // Makes room for at least one more element. When tombstones account
+      // for much of the load, rehashing at the same size reclaims them.
+      void grow()
+      {
+        if (groups == 0)
+          rehash(1);
+        else if (used < max_load() / 2)
+          rehash(groups);
+        else
+          rehash(groups * 2);
+      }
+
+      // Moves all elements into a new table with `n` groups.
+      void rehash(std::size_t n)
+      {
+        flat_table t;
+        t.allocate(n);
+        for (std::size_t i = 0; i != capacity(); ++i) {
+          if (ctrl[i] >= 0) {
+            std::size_t hash = hash_of(Policy::key(slots[i]));
+            std::size_t j = t.find_free(hash);
+            std::construct_at(t.slots + j, std::move(slots[i]));
+            t.ctrl[j] = tag_of(hash);
+          }
+        }
+        t.used = used;
+        t.growth_left = t.max_load() - used;
+        swap(t);
+      }
+
+      void allocate(std::size_t n)
+      {
+        groups = n;
+        ctrl = new ctrl_t[capacity()];
+        std::fill_n(ctrl, capacity(), ctrl_empty);
+        slots = std::allocator<value_type>().allocate(capacity());
+        growth_left = max_load();
+      }
+
+      void destroy() noexcept
+      {
+        if (groups == 0)
+          return;
+        for (std::size_t i = 0; i != capacity(); ++i)
+          if (ctrl[i] >= 0)
+            std::destroy_at(slots + i);
+        std::allocator<value_type>().deallocate(slots, capacity());
+        delete[] ctrl;
+      }
+
+      /// The control bytes, one per slot.
+      ctrl_t* ctrl = nullptr;
+
+      /// The element storage.
+      value_type* slots = nullptr;
+
+      /// The number of groups. This is zero or a power of two.
+      std::size_t groups = 0;
+
+      /// The number of elements.
+      std::size_t used = 0;
+
+      /// The number of empty slots that can be filled before growing.
+      std::size_t growth_left = 0;
+    };
+
+    template<typename K, typename T>
+    struct map_policy
+    {
+      using key_type = K;
+      using value_type = std::pair<K const, T>;
+
+      static constexpr bool mutable_values = true;
+
+      static K const& key(value_type const& v) noexcept
+      {
+        return v.first;
+      }
+    };
+
+    template<typename K>
+    struct set_policy
+    {
+      using key_type = K;
+      using value_type = K;
+
+      static constexpr bool mutable_values = false;
+
+      static K const& key(value_type const& v) noexcept
+      {
+        return v;
+      }
+    };
+
+  } // namespace detail
+
+  /// A hash map with open addressing, keyed by lock3::hash.
+  ///
+  /// Elements are stored inline in a single array, so there is no
+  /// allocation per element and no pointer chasing on lookup. Any key that
+  /// can be hashed with `H` through hash_append can be used. Keys are
+  /// compared with lock3::equal_to by default, the structural equality that
+  /// matches lock3::hash, so keys need not define `operator==`.
+  ///
+  /// Unlike std::unordered_map, inserting or erasing an element invalidates
+  /// all iterators, and rehashing moves elements.
+  template<typename Key,
+           typename T,
+           hash_algorithm H = fn1va64_hasher,
+           typename Eq = lock3::equal_to>
+    requires hashable_with<Key, H>
+  class flat_map : public detail::flat_table<detail::map_policy<Key, T>, H, Eq>
+  {
+    using base = detail::flat_table<detail::map_policy<Key, T>, H, Eq>;
+
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using typename base::value_type;
+    using typename base::iterator;
+    using typename base::const_iterator;
+
+    flat_map() = default;
+
+    flat_map(std::initializer_list<value_type> list)
+    {
+      this->reserve(list.size());
+      for (value_type const& v : list)
+        insert(v);
+    }
+
+    std::pair<iterator, bool> insert(value_type const& v)
+    {
+      return this->emplace_key(v.first, v);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& v)
+    {
+      return this->emplace_key(v.first, std::move(v));
+    }
+
+    /// Inserts `key` mapped to a value constructed from `args`, unless
+    /// `key` is already present.
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key const& key, Args&&... args)
+    {
+      return this->emplace_key(key,
+                               std::piecewise_construct,
+                               std::forward_as_tuple(key),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+    {
+      return this->emplace_key(key,
+                               std::piecewise_construct,
+                               std::forward_as_tuple(std::move(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    T& operator[](Key const& key)
+    {
+      return try_emplace(key).first->second;
+    }
+
+    T& at(Key const& key)
+    {
+      auto iter = this->find(key);
+      if (iter == this->end())
+        throw std::out_of_range("lock3::flat_map::at");
+      return iter->second;
+    }
+
+    T const& at(Key const& key) const
+    {
+      auto iter = this->find(key);
+      if (iter == this->end())
+        throw std::out_of_range("lock3::flat_map::at");
+      return iter->second;
+    }
+  };
+
+  /// A hash set with open addressing, keyed by lock3::hash. See flat_map.
+  template<typename Key,
+           hash_algorithm H = fn1va64_hasher,
+           typename Eq = lock3::equal_to>
+    requires hashable_with<Key, H>
+  class flat_set : public detail::flat_table<detail::set_policy<Key>, H, Eq>
+  {
+    using base = detail::flat_table<detail::set_policy<Key>, H, Eq>;
+
+  public:
+    using key_type = Key;
+    using typename base::value_type;
+    using typename base::iterator;
+    using typename base::const_iterator;
+
+    flat_set() = default;
+
+    flat_set(std::initializer_list<Key> list)
+    {
+      this->reserve(list.size());
+      for (Key const& k : list)
+        insert(k);
+    }
+
+    std::pair<iterator, bool> insert(Key const& key)
+    {
+      return this->emplace_key(key, key);
+    }
+
+    std::pair<iterator, bool> insert(Key&& key)
+    {
+      return this->emplace_key(key, std::move(key));
+    }
+  };
+
+} // namespace lock3
+
+#endif
@@ -20,7 +20,7 @@ namespace game
     ratio magic;
 
     template<lock3::hash_algorithm H>
-    void hash_append(H& hash) const
+    constexpr void hash_append(H& hash) const
     {
       lock3::hash_append(hash, name);
       lock3::hash_append(hash, health);
@@ -33,7 +33,7 @@ namespace game
     int id;
 
     template<lock3::hash_algorithm H>
-    friend void hash_append(H& hash, monster const& m)
+    friend constexpr void hash_append(H& hash, monster const& m)
     {
       lock3::hash_append(hash, m.id);
     }
@@ -61,7 +61,7 @@ namespace game
   };
 
   template<lock3::hash_algorithm H>
-  void hash_append(H& hash, item const& i)
+  constexpr void hash_append(H& hash, item const& i)
   {
     lock3::hash_append(hash, i.id);
   }
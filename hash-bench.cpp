@@ -0,0 +1,422 @@
+#include "hash.hpp"
+#include "crc.hpp"
+#include "game.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#endif
+
+// Measures the speed and distribution quality of hash algorithms.
+//
+// Speed is reported in bytes per second and cycles per hash over key sizes
+// from 1 byte to 1 MB. Quality is measured with tests in the style of
+// SMHasher: avalanche (each input bit should flip each output bit with
+// probability 1/2), bit independence (output bit flips should be pairwise
+// uncorrelated), and bucket collisions (keys should fill 2^k buckets like
+// random values, whether buckets are chosen by low or high bits). The
+// quality tests run on raw byte keys and on reflected structs hashed through
+// lock3::hash, such as game::player.
+
+// Returns the cycle counter, or 0 where there isn't one.
+inline std::uint64_t cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// Prevents the compiler from discarding `x`.
+template<typename T>
+inline void keep(T const& x)
+{
+  asm volatile("" : : "r,m"(x) : "memory");
+}
+
+template<typename H>
+using result_t = lock3::hash_result_t<H>;
+
+// Hashes `n` bytes at `p` with a fresh `H`.
+template<typename H>
+result_t<H> hash_bytes(void const* p, std::size_t n)
+{
+  H hash;
+  hash(p, n);
+  return (result_t<H>)hash;
+}
+
+// Speed
+
+template<typename H>
+void bench_speed(char const* name)
+{
+  std::vector<unsigned char> buf((1 << 20) + 64);
+  std::mt19937_64 rng(1);
+  for (unsigned char& c : buf)
+    c = (unsigned char)rng();
+
+  std::cout << name << '\n';
+  for (std::size_t len = 1; len <= (1 << 20); len *= 4) {
+    // Aim for about 256 MB of input, but at least 1M hashes of short keys.
+    std::size_t iters = std::max<std::size_t>((256u << 20) / len, 1);
+    iters = std::min<std::size_t>(iters, 1 << 22);
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t c0 = cycles();
+    for (std::size_t i = 0; i < iters; ++i)
+      keep(hash_bytes<H>(buf.data() + (i & 63), len));
+    std::uint64_t c1 = cycles();
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+
+    double bytes_per_sec = (double)len * iters / secs.count();
+    std::cout << std::setw(10) << len << " B"
+              << std::fixed << std::setprecision(1)
+              << std::setw(12) << bytes_per_sec / 1e6 << " MB/s";
+    if (c1 != c0)
+      std::cout << std::setw(14) << (double)(c1 - c0) / iters << " cycles/hash";
+    std::cout << '\n';
+  }
+}
+
+// Hashes reflected structs through lock3::hash.
+template<typename H>
+void bench_struct_speed(char const* name)
+{
+  std::vector<game::player> players;
+  for (int i = 0; i < 1024; ++i)
+    players.push_back({"player" + std::to_string(i), {i, i}, {i * 2, i}});
+
+  constexpr std::size_t iters = 1 << 22;
+  lock3::hash<H> hash;
+  auto start = std::chrono::steady_clock::now();
+  std::uint64_t c0 = cycles();
+  for (std::size_t i = 0; i < iters; ++i)
+    keep(hash(players[i & 1023]));
+  std::uint64_t c1 = cycles();
+  std::chrono::duration<double, std::nano> ns = std::chrono::steady_clock::now() - start;
+
+  std::cout << std::setw(24) << name << std::fixed << std::setprecision(1)
+            << std::setw(10) << ns.count() / iters << " ns/player";
+  if (c1 != c0)
+    std::cout << std::setw(10) << (double)(c1 - c0) / iters << " cycles/player";
+  std::cout << '\n';
+}
+
+// Hashes batches of 256 keys with hash_batch and with one call per key.
+template<typename H, typename T>
+void bench_batch(char const* name)
+{
+  std::vector<T> keys(256);
+  std::mt19937_64 rng(1);
+  for (T& key : keys)
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+      reinterpret_cast<unsigned char*>(&key)[i] = (unsigned char)rng();
+
+  constexpr std::size_t iters = 1 << 14;
+  std::vector<result_t<H>> codes(keys.size());
+  lock3::hash<H> hash;
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iters; ++i) {
+    for (std::size_t j = 0; j < keys.size(); ++j)
+      codes[j] = hash(keys[j]);
+    keep(codes.data());
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iters; ++i) {
+    lock3::hash_batch<H, T>(keys, codes);
+    keep(codes.data());
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double, std::nano> single = mid - start;
+  std::chrono::duration<double, std::nano> batch = stop - mid;
+  double n = (double)iters * keys.size();
+  std::cout << std::setw(24) << name << std::setw(6) << sizeof(T) << " B"
+            << std::fixed << std::setprecision(2)
+            << std::setw(10) << single.count() / n << " ns/key"
+            << std::setw(10) << batch.count() / n << " ns/key batched\n";
+}
+
+// Avalanche and bit independence
+
+// Flips each of the `in_bits` input bits of random keys and reports:
+//
+//  - the worst avalanche bias: max over (input bit, output bit) of
+//    |2p - 1|, where p is the probability that the output bit flips;
+//  - the worst bit independence correlation: max over (input bit, output
+//    bit pair) of the correlation between the two output bits' flips.
+//
+// Both are 0 for an ideal hash. SMHasher treats biases above 1% as failures.
+//
+// `randomize(key, rng)` fills `key` with random values, `flip(key, i)`
+// flips its input bit `i`, and `hash(key)` returns its hash code.
+template<typename Key, typename Randomize, typename Flip, typename Hash>
+void test_avalanche(char const* name, char const* keyset, int in_bits, int samples,
+                    Randomize randomize, Flip flip, Hash hash)
+{
+  using R = decltype(hash(std::declval<Key const&>()));
+  constexpr int out_bits = std::numeric_limits<R>::digits;
+
+  // flips[i][j]: how often flipping input bit i flipped output bit j.
+  // pairs[i][j][k]: how often both j and k flipped.
+  std::vector<int> flips(in_bits * out_bits);
+  std::vector<int> pairs(in_bits * out_bits * out_bits);
+
+  std::mt19937_64 rng(in_bits);
+  Key key {};
+  for (int s = 0; s < samples; ++s) {
+    randomize(key, rng);
+    R base = hash(key);
+    for (int i = 0; i < in_bits; ++i) {
+      flip(key, i);
+      R diff = base ^ hash(key);
+      flip(key, i);
+      for (R d = diff; d != 0; d &= d - 1) {
+        int j = std::countr_zero(d);
+        ++flips[i * out_bits + j];
+        for (R e = d & (d - 1); e != 0; e &= e - 1)
+          ++pairs[(i * out_bits + j) * out_bits + std::countr_zero(e)];
+      }
+    }
+  }
+
+  double worst_bias = 0;
+  double worst_corr = 0;
+  for (int i = 0; i < in_bits; ++i) {
+    for (int j = 0; j < out_bits; ++j) {
+      double pj = (double)flips[i * out_bits + j] / samples;
+      worst_bias = std::max(worst_bias, std::abs(2 * pj - 1));
+      for (int k = j + 1; k < out_bits; ++k) {
+        double pk = (double)flips[i * out_bits + k] / samples;
+        double pjk = (double)pairs[(i * out_bits + j) * out_bits + k] / samples;
+        double var = std::sqrt(pj * (1 - pj) * pk * (1 - pk));
+        double corr = var > 0 ? std::abs(pjk - pj * pk) / var : 1;
+        worst_corr = std::max(worst_corr, corr);
+      }
+    }
+  }
+
+  std::cout << std::setw(24) << name << std::setw(18) << keyset
+            << std::fixed << std::setprecision(2)
+            << std::setw(14) << worst_bias * 100 << "% bias"
+            << std::setw(14) << worst_corr * 100 << "% BIC\n";
+}
+
+// Flips bit `i` of the object representation at `p`.
+inline void flip_bit(void* p, int i)
+{
+  static_cast<unsigned char*>(p)[i / 8] ^= (unsigned char)(1u << (i % 8));
+}
+
+// Fills the `n` bytes at `p` with random values.
+inline void fill_random(void* p, std::size_t n, std::mt19937_64& rng)
+{
+  for (std::size_t i = 0; i < n; ++i)
+    static_cast<unsigned char*>(p)[i] = (unsigned char)rng();
+}
+
+// A reflected class with padding and floating point members.
+struct sample
+{
+  char tag;
+  int id;
+  double value;
+};
+
+// Avalanche over random `Len`-byte keys, hashed directly with `H`.
+template<typename H, std::size_t Len>
+void test_byte_avalanche(char const* name, int samples)
+{
+  using key = std::array<unsigned char, Len>;
+  std::string keyset = std::to_string(Len) + " B";
+  test_avalanche<key>(
+    name, keyset.c_str(), Len * 8, samples,
+    [](key& k, std::mt19937_64& rng) { fill_random(k.data(), Len, rng); },
+    [](key& k, int i) { flip_bit(k.data(), i); },
+    [](key const& k) { return hash_bytes<H>(k.data(), Len); });
+}
+
+// Avalanche over the members of reflected structs, hashed through
+// lock3::hash. Only the bits of values are flipped, never padding.
+template<typename H>
+void test_struct_avalanche(char const* name, int samples)
+{
+  lock3::hash<H> hash;
+
+  test_avalanche<game::ratio>(
+    name, "game::ratio", 64, samples,
+    [](game::ratio& r, std::mt19937_64& rng) { fill_random(&r, sizeof(r), rng); },
+    [](game::ratio& r, int i) { flip_bit(&r, i); },
+    hash);
+
+  // An 8-character name followed by the health and magic ratios.
+  test_avalanche<game::player>(
+    name, "game::player", 192, samples,
+    [](game::player& p, std::mt19937_64& rng) {
+      p.name.resize(8);
+      fill_random(p.name.data(), 8, rng);
+      fill_random(&p.health, sizeof(p.health), rng);
+      fill_random(&p.magic, sizeof(p.magic), rng);
+    },
+    [](game::player& p, int i) {
+      if (i < 64)
+        flip_bit(p.name.data(), i);
+      else if (i < 128)
+        flip_bit(&p.health, i - 64);
+      else
+        flip_bit(&p.magic, i - 128);
+    },
+    hash);
+
+  // The tag, the id, and then the value.
+  test_avalanche<sample>(
+    name, "padded struct", 104, samples,
+    [](sample& x, std::mt19937_64& rng) {
+      fill_random(&x.tag, sizeof(x.tag), rng);
+      fill_random(&x.id, sizeof(x.id), rng);
+      fill_random(&x.value, sizeof(x.value), rng);
+    },
+    [](sample& x, int i) {
+      if (i < 8)
+        flip_bit(&x.tag, i);
+      else if (i < 40)
+        flip_bit(&x.id, i - 8);
+      else
+        flip_bit(&x.value, i - 40);
+    },
+    hash);
+}
+
+// Bucket collisions
+
+// Reports the ratio of actual to expected collisions when `codes` are
+// placed in 2^bits buckets using their low bits and their high bits. An
+// ideal hash scores 1.0 in both.
+template<typename R>
+void report_collisions(char const* name, char const* keyset,
+                       std::vector<R> const& codes, int bits)
+{
+  constexpr int digits = std::numeric_limits<R>::digits;
+  std::size_t buckets = std::size_t(1) << bits;
+  double n = (double)codes.size();
+  double expected = n - buckets + buckets * std::pow(1 - 1 / (double)buckets, n);
+
+  auto collisions = [&](auto bucket_of) {
+    std::vector<unsigned char> used(buckets);
+    std::size_t count = 0;
+    for (R code : codes) {
+      unsigned char& u = used[bucket_of(code)];
+      count += u;
+      u = 1;
+    }
+    return (double)count;
+  };
+
+  double low = collisions([&](R c) { return c & (buckets - 1); });
+  double high = collisions([&](R c) { return c >> (digits - bits); });
+
+  std::cout << std::setw(24) << name << std::setw(18) << keyset
+            << std::fixed << std::setprecision(3)
+            << std::setw(10) << low / expected << " low"
+            << std::setw(10) << high / expected << " high\n";
+}
+
+template<typename H>
+void test_collisions(char const* name)
+{
+  using R = result_t<H>;
+  constexpr std::size_t n = 1 << 18;
+  constexpr int bits = 20;
+  lock3::hash<H> hash;
+
+  // Sequential integers.
+  std::vector<R> codes;
+  for (std::uint32_t i = 0; i < n; ++i)
+    codes.push_back(hash(i));
+  report_collisions(name, "sequential int", codes, bits);
+
+  // Sparse keys: 64-bit integers with at most two bits set.
+  codes.clear();
+  for (int i = 0; i < 64; ++i)
+    for (int j = i; j < 64; ++j)
+      codes.push_back(hash((std::uint64_t(1) << i) | (std::uint64_t(1) << j)));
+  report_collisions(name, "sparse uint64", codes, 12);
+
+  // Reflected structs that differ only in small fields.
+  codes.clear();
+  for (int i = 0; i < 512; ++i)
+    for (int j = 0; j < 512; ++j)
+      codes.push_back(hash(game::player {"p", {i, j}, {100, 100}}));
+  report_collisions(name, "game::player", codes, bits);
+
+  // Reflected classes with padding and floating point members.
+  codes.clear();
+  for (std::size_t i = 0; i < n; ++i)
+    codes.push_back(hash(sample {'s', (int)i, i * 0.5}));
+  report_collisions(name, "padded struct", codes, bits);
+}
+
+int main(int argc, char* argv[])
+{
+  using namespace lock3;
+
+  // Pass "--quick" to skip the slower quality tests.
+  bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+  int samples = quick ? 2000 : 20000;
+
+  std::cout << "== Throughput ==\n";
+  bench_speed<fn1va32_hasher>("fn1va32_hasher");
+  bench_speed<fn1va64_hasher>("fn1va64_hasher");
+  bench_speed<xxh64_hasher>("xxh64_hasher");
+  bench_speed<buffered_hasher<xxh64_hasher>>("buffered_hasher<xxh64>");
+  bench_speed<crc32c_hasher>("crc32c_hasher");
+
+  std::cout << "\n== Reflected structs (lock3::hash) ==\n";
+  bench_struct_speed<fn1va32_hasher>("fn1va32_hasher");
+  bench_struct_speed<fn1va64_hasher>("fn1va64_hasher");
+  bench_struct_speed<xxh64_hasher>("xxh64_hasher");
+  bench_struct_speed<crc32c_hasher>("crc32c_hasher");
+
+  std::cout << "\n== Batches of 256 keys ==\n";
+  struct key16 { std::uint64_t a, b; };
+  bench_batch<fn1va64_hasher, std::uint32_t>("fn1va64_hasher");
+  bench_batch<fn1va64_hasher, std::uint64_t>("fn1va64_hasher");
+  bench_batch<fn1va64_hasher, key16>("fn1va64_hasher");
+  bench_batch<xxh64_hasher, std::uint64_t>("xxh64_hasher");
+  bench_batch<crc32c_hasher, std::uint64_t>("crc32c_hasher");
+
+  std::cout << "\n== Avalanche / bit independence ==\n";
+  test_byte_avalanche<fn1va32_hasher, 4>("fn1va32_hasher", samples);
+  test_byte_avalanche<fn1va64_hasher, 8>("fn1va64_hasher", samples);
+  test_byte_avalanche<fn1va64_hasher, 16>("fn1va64_hasher", samples);
+  test_byte_avalanche<xxh64_hasher, 8>("xxh64_hasher", samples);
+  test_byte_avalanche<xxh64_hasher, 16>("xxh64_hasher", samples);
+  test_byte_avalanche<crc32c_hasher, 8>("crc32c_hasher", samples);
+
+  std::cout << "\n== Avalanche / bit independence, reflected structs ==\n";
+  test_struct_avalanche<fn1va32_hasher>("fn1va32_hasher", samples);
+  test_struct_avalanche<fn1va64_hasher>("fn1va64_hasher", samples);
+  test_struct_avalanche<xxh64_hasher>("xxh64_hasher", samples);
+  test_struct_avalanche<crc32c_hasher>("crc32c_hasher", samples);
+
+  std::cout << "\n== Bucket collisions (actual / expected) ==\n";
+  test_collisions<fn1va32_hasher>("fn1va32_hasher");
+  test_collisions<fn1va64_hasher>("fn1va64_hasher");
+  test_collisions<xxh64_hasher>("xxh64_hasher");
+  test_collisions<crc32c_hasher>("crc32c_hasher");
+}
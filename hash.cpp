@@ -1,8 +1,11 @@
 #include "hash.hpp"
+#include "crc.hpp"
+#include "tree_hash.hpp"
 #include "game.hpp"
 
 #include <iostream>
 #include <iomanip>
+#include <string>
 #include <vector>
 #include <tuple>
 #include <unordered_map>
@@ -44,9 +47,10 @@ struct debug_hasher
   std::vector<unsigned char> buf;
 };
 
+template<lock3::hash_algorithm H>
 void test_unordered_map()
 {
-  using hash = lock3::hash<lock3::fn1va64_hasher>;
+  using hash = lock3::hash<H>;
   std::unordered_map<game::item, int, hash> prices;
   prices.emplace(game::item {0}, 100);
   prices.emplace(game::item {1}, 200);
@@ -56,6 +60,91 @@ void test_unordered_map()
   assert(prices.find(game::item {42}) == prices.end());
 }
 
+// Buffering must not change the digest.
+void test_buffered()
+{
+  game::player andrew {"andrew", {100, 100}, {50, 50}};
+
+  lock3::xxh64_hasher direct;
+  lock3::hash_append(direct, andrew);
+
+  lock3::hash<lock3::xxh64_hasher> hash;
+  assert(hash(andrew) == (std::uint64_t)direct);
+}
+
+// Tree hashing must not depend on the number of threads.
+void test_tree()
+{
+  std::vector<unsigned char> buf(16 << 20);
+  for (std::size_t i = 0; i < buf.size(); ++i)
+    buf[i] = (unsigned char)(i * 131);
+
+  lock3::tree_hasher<lock3::xxh64_hasher> serial(1);
+  lock3::hash_append(serial, buf);
+
+  lock3::tree_hasher<lock3::xxh64_hasher> parallel;
+  lock3::hash_append(parallel, buf);
+
+  assert((std::uint64_t)serial == (std::uint64_t)parallel);
+}
+
+// Hashing in a constant expression must agree with hashing at run time.
+template<lock3::hash_algorithm H>
+void test_constexpr()
+{
+  using hash = lock3::hash<H>;
+  constexpr auto ratio = hash{}(game::ratio {100, 50});
+  constexpr auto item = hash{}(game::item {42});
+  constexpr auto tuple = hash{}(std::make_tuple(42, 'a', -0.0));
+  constexpr auto player = hash{}(game::player {"andrew", {100, 100}, {50, 50}});
+
+  game::player andrew {"andrew", {100, 100}, {50, 50}};
+  assert(ratio == hash{}(game::ratio {100, 50}));
+  assert(item == hash{}(game::item {42}));
+  assert(tuple == hash{}(std::make_tuple(42, 'a', 0.0)));
+  assert(player == hash{}(andrew));
+}
+
+// Batched hashing must agree with hashing each key.
+template<lock3::hash_algorithm H>
+void test_batch()
+{
+  struct point { int x, y; };
+  std::vector<point> points;
+  std::vector<std::string> names;
+  for (int i = 0; i < 29; ++i) {
+    points.push_back({i, -i});
+    names.push_back(std::string(i, 'x'));
+  }
+
+  lock3::hash<H> hash;
+  std::vector<lock3::hash_result_t<H>> codes(points.size());
+  lock3::hash_batch<H, point>(points, codes);
+  for (std::size_t i = 0; i < points.size(); ++i)
+    assert(codes[i] == hash(points[i]));
+
+  lock3::hash_batch<H, std::string>(names, codes);
+  for (std::size_t i = 0; i < names.size(); ++i)
+    assert(codes[i] == hash(names[i]));
+}
+
+// Strings of every kind must hash alike through lock3::hash.
+template<lock3::hash_algorithm H>
+void test_transparent()
+{
+  lock3::hash<H> hash;
+  std::string str = "sword";
+  std::string_view view = str;
+  char buf[] = "sword";
+  char const* cstr = buf;
+  char const* null = nullptr;
+  assert(hash(str) == hash(view));
+  assert(hash(str) == hash(cstr));
+  assert(hash(null) == hash(std::string_view()));
+  assert(hash(str) == hash(buf));
+  assert(hash(str) == hash("sword"));
+}
+
 int main()
 {
   using namespace lock3;
@@ -80,15 +169,21 @@ int main()
   class S0 { };
   class S1 { int x = 42; };
   struct S2 { int x = 42; private: int y = 42; };
+  struct S3 { char c = 'a'; int x = 42, y = 42; double d = -0.0; };
   struct S { union { int x; }; };
 
   hash_append(h, S0());
   hash_append(h, S1());
   hash_append(h, S2());
+  hash_append(h, S3()); // runs: {c}, {x, y}, then d by itself
   // hash_append(h, S()); // error: anonymous union
   hash_append(h, std::make_pair(42, 'a'));
   hash_append(h, std::make_tuple(42, 'a', 32.0));
 
+  // Ranges
+  hash_append(h, std::vector<int> {1, 2, 3});
+  hash_append(h, std::vector<double> {1.5, -0.0, 0.0});
+
   game::player andrew {"andrew", {100, 100}, {50, 50}};
   hash_append(h, andrew);
 
@@ -100,7 +195,18 @@ int main()
 
   h.dump(std::cout);
 
-  test_unordered_map();
+  test_unordered_map<fn1va64_hasher>();
+  test_unordered_map<xxh64_hasher>();
+  test_unordered_map<crc32c_hasher>();
+  test_buffered();
+  test_tree();
+  test_constexpr<fn1va64_hasher>();
+  test_constexpr<xxh64_hasher>();
+  test_batch<fn1va32_hasher>();
+  test_batch<fn1va64_hasher>();
+  test_batch<xxh64_hasher>();
+  test_transparent<fn1va64_hasher>();
+  test_transparent<xxh64_hasher>();
 
   // FIXME: Test bitwise hashable things.
 }
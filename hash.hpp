@@ -3,10 +3,18 @@
 
 #include "concepts.hpp"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <concepts>
 #include <ranges>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace lock3
 {
@@ -16,7 +24,7 @@ namespace lock3
   {
     using result_type = T;
 
-    fn1va_hash()
+    constexpr fn1va_hash()
       : code(Offset)
     {
     }
@@ -24,14 +32,20 @@ namespace lock3
     /// Hash bytes into the code.
     void operator()(const void* p, std::size_t n)
     {
-      unsigned char const* first = static_cast<unsigned char const*>(p);
+      operator()(static_cast<unsigned char const*>(p), n);
+    }
+
+    /// Hash bytes into the code. Unlike the overload above, this can be used
+    /// in constant expressions.
+    constexpr void operator()(unsigned char const* first, std::size_t n)
+    {
       unsigned char const* limit = first + n;
       for (; first != limit; ++first)
         code = (code ^ *first) * Prime;
     }
 
     /// Converts to the computed hash code.
-    explicit operator result_type() const
+    constexpr explicit operator result_type() const
     {
       return code;
     }
@@ -50,6 +64,177 @@ namespace lock3
   {
   };
 
+  /// The xxHash64 algorithm. This consumes its input in 32-byte stripes
+  /// using four independent accumulators, which makes it much faster than
+  /// fnv1a on long buffers. Short keys take a tail path that mixes 8, 4,
+  /// and then 1 byte at a time.
+  ///
+  /// Input that does not fill a stripe is kept in a small buffer, so the
+  /// result depends only on the sequence of bytes hashed, not on how those
+  /// bytes are split across calls.
+  struct xxh64_hasher
+  {
+    using result_type = std::uint64_t;
+
+    /// The number of bytes consumed by each step of the main loop.
+    static constexpr std::size_t block_size = 32;
+
+    constexpr xxh64_hasher()
+      : xxh64_hasher(0)
+    {
+    }
+
+    constexpr explicit xxh64_hasher(std::uint64_t seed)
+      : acc{seed + prime1 + prime2, seed + prime2, seed, seed - prime1},
+        seed(seed)
+    {
+    }
+
+    /// Hash bytes into the accumulators.
+    void operator()(const void* p, std::size_t n) noexcept
+    {
+      operator()(static_cast<unsigned char const*>(p), n);
+    }
+
+    /// Hash bytes into the accumulators. This can be used in constant
+    /// expressions.
+    constexpr void operator()(unsigned char const* first, std::size_t n) noexcept
+    {
+      unsigned char const* limit = first + n;
+      total += n;
+
+      // Top off a partially filled stripe.
+      if (fill != 0) {
+        std::size_t k = block_size - fill;
+        if (n < k) {
+          std::copy_n(first, n, buf + fill);
+          fill += n;
+          return;
+        }
+        std::copy_n(first, k, buf + fill);
+        consume(buf);
+        first += k;
+        fill = 0;
+      }
+
+      // Consume whole stripes directly from the input.
+      for (; limit - first >= (std::ptrdiff_t)block_size; first += block_size)
+        consume(first);
+
+      // Save the rest for later.
+      fill = limit - first;
+      std::copy_n(first, fill, buf);
+    }
+
+    /// Converts to the computed hash code.
+    constexpr explicit operator result_type() const noexcept
+    {
+      std::uint64_t h;
+      if (total >= block_size) {
+        h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+        for (std::uint64_t a : acc)
+          h = (h ^ round(0, a)) * prime1 + prime4;
+      }
+      else {
+        h = seed + prime5;
+      }
+      h += total;
+
+      // The tail path.
+      unsigned char const* p = buf;
+      unsigned char const* limit = buf + fill;
+      for (; limit - p >= 8; p += 8)
+        h = rotl(h ^ round(0, load64(p)), 27) * prime1 + prime4;
+      if (limit - p >= 4) {
+        h = rotl(h ^ (load32(p) * prime1), 23) * prime2 + prime3;
+        p += 4;
+      }
+      for (; p != limit; ++p)
+        h = rotl(h ^ (*p * prime5), 11) * prime1;
+
+      // Final avalanche.
+      h ^= h >> 33;
+      h *= prime2;
+      h ^= h >> 29;
+      h *= prime3;
+      h ^= h >> 32;
+      return h;
+    }
+
+  private:
+    static constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    static constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+    static constexpr std::uint64_t prime3 = 0x165667B19E3779F9ull;
+    static constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+    static constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+    static constexpr std::uint64_t rotl(std::uint64_t x, int r) noexcept
+    {
+      return (x << r) | (x >> (64 - r));
+    }
+
+    static constexpr std::uint64_t round(std::uint64_t acc, std::uint64_t input) noexcept
+    {
+      return rotl(acc + input * prime2, 31) * prime1;
+    }
+
+    // NOTE: xxHash is defined over little-endian loads. Loads are assembled
+    // byte by byte during constant evaluation, where memcpy is not allowed.
+    template<typename T>
+    static constexpr T load(unsigned char const* p) noexcept
+    {
+      if (std::is_constant_evaluated()) {
+        T x = 0;
+        for (std::size_t i = 0; i != sizeof(T); ++i)
+          x |= T(p[i]) << (8 * i);
+        return x;
+      }
+      T x;
+      std::memcpy(&x, p, sizeof(x));
+      if constexpr (std::endian::native == std::endian::big) {
+        if constexpr (sizeof(T) == 8)
+          x = __builtin_bswap64(x);
+        else
+          x = __builtin_bswap32(x);
+      }
+      return x;
+    }
+
+    static constexpr std::uint64_t load64(unsigned char const* p) noexcept
+    {
+      return load<std::uint64_t>(p);
+    }
+
+    static constexpr std::uint64_t load32(unsigned char const* p) noexcept
+    {
+      return load<std::uint32_t>(p);
+    }
+
+    // Mix one 32-byte stripe into the accumulators.
+    constexpr void consume(unsigned char const* p) noexcept
+    {
+      acc[0] = round(acc[0], load64(p));
+      acc[1] = round(acc[1], load64(p + 8));
+      acc[2] = round(acc[2], load64(p + 16));
+      acc[3] = round(acc[3], load64(p + 24));
+    }
+
+    /// The four stripe accumulators.
+    std::uint64_t acc[4];
+
+    /// The seed, needed again for short inputs.
+    std::uint64_t seed;
+
+    /// The total number of bytes hashed.
+    std::uint64_t total = 0;
+
+    /// Bytes waiting for a full stripe.
+    unsigned char buf[block_size] {};
+
+    /// The number of bytes in `buf`.
+    std::size_t fill = 0;
+  };
+
   // hash_algorithm
 
   /// Satisfied when `H` is a hash algorithm.
@@ -68,6 +253,121 @@ namespace lock3
   template<hash_algorithm H>
   using hash_result_t = typename H::result_type;
 
+  // buffered_hasher
+
+  namespace detail
+  {
+    // Satisfied if `H` consumes its input in fixed-size blocks, which it
+    // advertises with a static `block_size` member. These are the algorithms
+    // that benefit from being fed large chunks at once.
+    template<typename H>
+    concept block_hash_algorithm =
+      hash_algorithm<H> &&
+      requires {
+        { H::block_size } -> std::convertible_to<std::size_t>;
+      };
+
+    // The granularity at which a buffered hasher flushes its input.
+    template<hash_algorithm H>
+    constexpr std::size_t hash_block_size()
+    {
+      if constexpr (block_hash_algorithm<H>)
+        return H::block_size;
+      else
+        return 1;
+    }
+  } // namespace detail
+
+  /// A hash algorithm adapter that collects appended bytes in a small buffer
+  /// and passes them on to `H` in whole blocks. Hashing a class appends each
+  /// scalar member separately, usually only 4 or 8 bytes at a time; this
+  /// turns those into a few large calls.
+  ///
+  /// The result is the same as feeding the same bytes directly to `H`,
+  /// provided that `H` depends only on the sequence of bytes and not on how
+  /// they are divided between calls. All of the algorithms in this library
+  /// have that property.
+  template<hash_algorithm H>
+  struct buffered_hasher
+  {
+    using result_type = hash_result_t<H>;
+
+    /// The size of the buffer: the multiple of H's block size nearest
+    /// to 256 bytes.
+    static constexpr std::size_t buffer_size = [] {
+      constexpr std::size_t block = detail::hash_block_size<H>();
+      return block < 256 ? 256 / block * block : block;
+    }();
+
+    constexpr buffered_hasher() = default;
+
+    constexpr explicit buffered_hasher(H const& hash)
+      : hash(hash)
+    {
+    }
+
+    /// Hash bytes into the buffer.
+    void operator()(const void* p, std::size_t n) noexcept
+    {
+      operator()(static_cast<unsigned char const*>(p), n);
+    }
+
+    /// Hash bytes into the buffer. This can be used in constant expressions
+    /// when `H` can.
+    constexpr void operator()(unsigned char const* p, std::size_t n) noexcept
+    {
+      if (n <= buffer_size - fill) {
+        std::copy_n(p, n, buf + fill);
+        fill += n;
+        return;
+      }
+      append_overflow(p, n);
+    }
+
+    /// Converts to the computed hash code. Any buffered bytes are given to a
+    /// copy of the underlying algorithm so that hashing can continue.
+    constexpr explicit operator result_type() const noexcept
+    {
+      H copy = hash;
+      if (fill != 0)
+        copy(buf, fill);
+      return (result_type)copy;
+    }
+
+  private:
+    // Fill and flush the buffer, pass whole blocks straight through, and
+    // keep the remainder.
+    constexpr void append_overflow(unsigned char const* p, std::size_t n) noexcept
+    {
+      constexpr std::size_t block = detail::hash_block_size<H>();
+      std::size_t k = buffer_size - fill;
+      std::copy_n(p, k, buf + fill);
+      hash(buf, buffer_size);
+      p += k;
+      n -= k;
+
+      std::size_t whole = n - n % block;
+      if (whole >= buffer_size) {
+        hash(p, whole);
+        p += whole;
+        n -= whole;
+      }
+
+      // Less than a buffer's worth remains.
+      std::copy_n(p, n, buf);
+      fill = n;
+    }
+
+    /// The underlying algorithm.
+    H hash;
+
+    /// Bytes not yet given to `hash`.
+    unsigned char buf[buffer_size] {};
+
+    /// The number of bytes in `buf`.
+    std::size_t fill = 0;
+  };
+
   // hash_append
 
   namespace detail
@@ -104,50 +404,154 @@ namespace lock3
       std::ranges::contiguous_range<R> &&
       std::has_unique_object_representations_v<std::ranges::range_value_t<R>>;
 
+    // A contiguous range of floating point values. These are not uniquely
+    // represented (0 and -0 compare equal), but can still be hashed in bulk.
+    template<typename R>
+    concept floating_point_range =
+      std::ranges::contiguous_range<R> &&
+      std::ranges::sized_range<R> &&
+      std::floating_point<std::ranges::range_value_t<R>>;
+
     // A class is bitwise hashable if it is uniquely represented.
     template<typename T>
     concept bitwise_hashable_class =
       std::has_unique_object_representations_v<T>;
 
+    // Satisfied if hash_append appends exactly the object representation of
+    // `T` in a single call and nothing else. Adjacent members of these types
+    // can be hashed together without changing the digest.
+    template<typename T, typename H>
+    concept bytewise_hashable =
+      std::has_unique_object_representations_v<T> &&
+      (std::integral<T> ||
+       enumeral<T> ||
+       std::is_pointer_v<T> ||
+       (class_type<T> &&
+        !member_hashable<T, H> &&
+        !adl_hashable<T, H> &&
+        !std::ranges::range<T> &&
+        (destructurable<T> || basic_data_type<T>)));
+
+    // Returns true if the address of the data member `M` of `T` can be taken
+    // (i.e., it is not a bit-field).
+    template<typename T, meta::info M>
+    consteval bool is_addressable_member()
+    {
+      return false;
+    }
+
+    template<typename T, meta::info M>
+      requires requires (T const& t) { &t.[:M:]; }
+    consteval bool is_addressable_member()
+    {
+      return true;
+    }
+
+    // Describes how a data member participates in hashing its class.
+    struct member_run
+    {
+      // True if the member is hashed as part of a run of bytes.
+      bool bytes = false;
+
+      // The length of the run that starts at this member, or 0 if the member
+      // continues an earlier run.
+      std::size_t length = 0;
+    };
+
+    // Partitions the data members of `T` into maximal runs of adjacent,
+    // bytewise hashable members with no padding between them.
+    //
+    // We don't query member offsets. Instead, a member joins the current run
+    // only if its alignment is no stricter than that of the run's first
+    // member and the run's length is a multiple of that alignment. In that
+    // case, the member must be placed immediately after the run, whatever
+    // the run's offset is. Anything else conservatively starts a new run.
+    //
+    // Inherited members are laid out by different rules (e.g., tail padding
+    // reuse), so classes with base class members are never partitioned.
+    template<typename H, typename T>
+    consteval auto member_runs_of()
+    {
+      constexpr auto subobjects = meta::subobjects_of(^T, meta::is_data_member);
+      constexpr auto members = meta::members_of(^T, meta::is_data_member);
+      constexpr std::size_t num = size(subobjects);
+
+      std::array<member_run, num> runs {};
+      if (num != size(members))
+        return runs;
+
+      std::size_t lead = 0;
+      std::size_t align = 0; // 0 when no run is open
+      template for (constexpr std::size_t I : ints(num)) {
+        constexpr meta::info sub = *std::next(subobjects.begin(), I);
+        using M = std::remove_cv_t<typename [:meta::type_of(sub):]>;
+        if constexpr (bytewise_hashable<M, H> && is_addressable_member<T, sub>()) {
+          if (align != 0 &&
+              alignof(M) <= align &&
+              runs[lead].length % alignof(M) == 0) {
+            runs[I] = {true, 0};
+            runs[lead].length += sizeof(M);
+          }
+          else {
+            runs[I] = {true, sizeof(M)};
+            lead = I;
+            align = alignof(M);
+          }
+        }
+        else {
+          align = 0;
+        }
+      }
+      return runs;
+    }
+
   } // namespace detail
 
+  /// Appends objects to a hash algorithm.
+  ///
+  /// Hashing can be done in constant expressions when `H` provides a
+  /// constexpr `operator()(unsigned char const*, std::size_t)` overload (all
+  /// of the algorithms in this library except crc32c_hasher do). During
+  /// constant evaluation, the bytes of each scalar are obtained with
+  /// std::bit_cast and appended one object at a time. The bytes appended
+  /// are the same as at run time, so the hash codes match.
   struct hash_append_fn
   {
     /// Append the bits of integral types.
     template<hash_algorithm H, std::integral T>
-    void operator()(H& hash, T t) const noexcept
+    constexpr void operator()(H& hash, T t) const noexcept
     {
-      hash(&t, sizeof(t));
+      append_bytes(hash, t);
     }
 
     /// Append the bits of enumeration types.
     template<hash_algorithm H, enumeral T>
-    void operator()(H& hash, T t) const noexcept
+    constexpr void operator()(H& hash, T t) const noexcept
     {
-      hash(&t, sizeof(t));
+      append_bytes(hash, t);
     }
 
     /// Append the bits of floating point types, but guarantee that 0 and -0
     /// have the same hash code since 0 == -0.
     template<hash_algorithm H, std::floating_point T>
-    void operator()(H& hash, T t) const noexcept
+    constexpr void operator()(H& hash, T t) const noexcept
     {
       if (t == 0)
         t = 0;
-      hash(&t, sizeof(t));
+      append_bytes(hash, t);
     }
 
     /// Append the bits of a pointer by hashing its representation, not the
     /// bits of the object pointed at (i.e., no indirection is performed).
     template<hash_algorithm H, typename T>
-    void operator()(H& hash, T* p) const noexcept
+    constexpr void operator()(H& hash, T* p) const noexcept
     {
       hash(&p, sizeof(p));
     }
 
     /// Hash the bits of the nullptr constant.
     template<hash_algorithm H>
-    inline void operator()(H& hash, std::nullptr_t p) const noexcept
+    constexpr void operator()(H& hash, std::nullptr_t p) const noexcept
     {
       hash(&p, sizeof(p));
     }
@@ -163,7 +567,7 @@ namespace lock3
     /// facilitatee those, we probably need to forward `obj` and rethink all
     /// our concepts.
     template<hash_algorithm H, detail::compound_hashable<H> T>
-    void operator()(H& hash, T const& obj) const noexcept
+    constexpr void operator()(H& hash, T const& obj) const noexcept
     {
       if constexpr (detail::member_hashable<T, H>)
         append_using_member(hash, obj);
@@ -177,9 +581,24 @@ namespace lock3
         append_data_type(hash, obj);
     }
 
+    // Append the object representation of `t`, which must not contain
+    // padding. An object's address cannot be reinterpreted as bytes during
+    // constant evaluation, so its bytes are copied out with bit_cast.
+    template<hash_algorithm H, typename T>
+    static constexpr void append_bytes(H& hash, T const& t) noexcept
+    {
+      if (std::is_constant_evaluated()) {
+        auto bytes = std::bit_cast<std::array<unsigned char, sizeof(T)>>(t);
+        hash(bytes.data(), bytes.size());
+      }
+      else {
+        hash(&t, sizeof(t));
+      }
+    }
+
     // Append for member customization.
     template<hash_algorithm H, detail::member_hashable<H> T>
-    void append_using_member(H& hash, T const& obj) const noexcept
+    constexpr void append_using_member(H& hash, T const& obj) const noexcept
     {
       obj.hash_append(hash);
     }
@@ -196,14 +615,14 @@ namespace lock3
     // The CPO approach works (presumably) because the hash_append has not
     // yet been declared in this scope.
     template<hash_algorithm H, detail::adl_hashable<H> T>
-    void append_using_adl(H& hash, T const& obj) const noexcept
+    constexpr void append_using_adl(H& hash, T const& obj) const noexcept
     {
       hash_append(hash, obj);
     }
 
     // Hash append for ranges.
     template<hash_algorithm H, std::ranges::range R>
-    void append_range(H& hash, R const& range) const noexcept
+    constexpr void append_range(H& hash, R const& range) const noexcept
     {
       std::size_t count = 0;
       for (auto const& elem : range) {
@@ -215,18 +634,54 @@ namespace lock3
 
     // Hash append for contiguous ranges of uniquely represented objects.
     template<hash_algorithm H, detail::bitwise_hashable_range R>
-    void append_range(H& hash, R const& range) const noexcept
+    constexpr void append_range(H& hash, R const& range) const noexcept
+    {
+      using T = std::ranges::range_value_t<R>;
+      std::size_t len = std::ranges::size(range);
+      if (std::is_constant_evaluated()) {
+        for (T const& elem : range)
+          append_bytes(hash, elem);
+      }
+      else {
+        hash(std::ranges::data(range), len * sizeof(T));
+      }
+      operator()(hash, len);
+    }
+
+    // Hash append for contiguous ranges of floating point values. Elements
+    // are normalized exactly as in the scalar case, but a block at a time in
+    // a loop that the compiler can vectorize, and each block is hashed with
+    // a single call. The bytes appended are the same as appending each
+    // element individually.
+    template<hash_algorithm H, detail::floating_point_range R>
+    constexpr void append_range(H& hash, R const& range) const noexcept
     {
-      auto* ptr = &*std::begin(range);
-      auto len = std::ranges::size(range);
-      hash(ptr, len);
+      using T = std::ranges::range_value_t<R>;
+      constexpr std::size_t block = 512 / sizeof(T);
+      T const* first = std::ranges::data(range);
+      std::size_t len = std::ranges::size(range);
+      if (std::is_constant_evaluated()) {
+        for (std::size_t i = 0; i < len; ++i)
+          operator()(hash, first[i]);
+        operator()(hash, len);
+        return;
+      }
+      T buf[block];
+      for (std::size_t i = 0; i < len; i += block) {
+        std::size_t n = len - i < block ? len - i : block;
+        for (std::size_t j = 0; j < n; ++j) {
+          T x = first[i + j];
+          buf[j] = x == 0 ? T(0) : x;
+        }
+        hash(buf, n * sizeof(T));
+      }
       operator()(hash, len);
     }
 
     // Hash append for tuples and other simple classes. Note that arrays
     // are handled by append_range, which takes precedence.
     template<hash_algorithm H, destructurable T>
-    void append_destructurable(H& hash, T const& obj) const noexcept
+    constexpr void append_destructurable(H& hash, T const& obj) const noexcept
     {
       static_assert(!std::is_array_v<T>);
       std::size_t count = 0;
@@ -240,31 +695,44 @@ namespace lock3
     // Hash append for uniquely represented destructurable classes.
     template<hash_algorithm H, destructurable T>
       requires detail::bitwise_hashable_class<T>
-    void append_destructurable(H& hash, T const& obj) const noexcept
+    constexpr void append_destructurable(H& hash, T const& obj) const noexcept
     {
-      hash(&obj, sizeof(obj));
+      append_bytes(hash, obj);
     }
 
     // Hash append for basic data types in an application domain.
+    //
+    // Runs of adjacent scalar (and uniquely represented class) members with
+    // no padding between them are hashed with a single call. This appends
+    // the same bytes as hashing each of those members separately. Other
+    // members (e.g., floating point values and strings) are appended
+    // individually.
     template<hash_algorithm H, basic_data_type T>
-    void append_data_type(H& hash, T const& obj) const noexcept
+    constexpr void append_data_type(H& hash, T const& obj) const noexcept
     {
       namespace meta = std::experimental::meta;
-      std::size_t count = 0;
       constexpr auto subobjects = meta::subobjects_of(^T, meta::is_data_member);
-      template for (constexpr meta::info sub : subobjects) {
-        operator()(hash, obj.[:sub:]);
-        ++count;
+      constexpr std::size_t num = size(subobjects);
+      constexpr auto runs = detail::member_runs_of<H, T>();
+      template for (constexpr std::size_t I : ints(num)) {
+        constexpr meta::info sub = *std::next(subobjects.begin(), I);
+        if constexpr (!runs[I].bytes)
+          operator()(hash, obj.[:sub:]);
+        else if (std::is_constant_evaluated())
+          append_bytes(hash, obj.[:sub:]);
+        else if constexpr (runs[I].length != 0)
+          hash(&obj.[:sub:], runs[I].length);
       }
+      std::size_t count = num;
       operator()(hash, count);
     }
 
     // Hash append for uniquely represented destructurable classes.
     template<hash_algorithm H, basic_data_type T>
       requires detail::bitwise_hashable_class<T>
-    void append_data_type(H& hash, T const& obj) const noexcept
+    constexpr void append_data_type(H& hash, T const& obj) const noexcept
     {
-      hash(&obj, sizeof(T));
+      append_bytes(hash, obj);
     }
   };
 
@@ -283,18 +751,84 @@ namespace lock3
   // hash object
 
   /// A hash function that can (presumably) work
+  ///
+  /// Block-based algorithms are wrapped in a buffered_hasher, so hashing a
+  /// class does not pay the per-call cost of `H` for each of its members.
+  ///
+  /// The hash is transparent: strings and C strings (see string_key) are
+  /// hashed as a std::string_view of their contents, so a std::string key
+  /// can be looked up with a string_view or a `char const*` without
+  /// constructing a std::string. Note that this differs from hash_append,
+  /// which hashes the value of a `char const*`, not the string it points
+  /// to. A null `char const*` hashes as the empty string.
   template<hash_algorithm H>
   struct hash
   {
-    template<hashable_with<H> T>
-    hash_result_t<H> operator()(const T& obj) const noexcept
+    using is_transparent = void;
+
+    /// The algorithm actually used to hash objects.
+    using algorithm_type =
+      std::conditional_t<detail::block_hash_algorithm<H>, buffered_hasher<H>, H>;
+
+    template<hashable_with<algorithm_type> T>
+    constexpr hash_result_t<H> operator()(const T& obj) const noexcept
     {
-      H hash;
-      hash_append(hash, obj);
+      algorithm_type hash;
+      if constexpr (string_key<T>)
+        hash_append(hash, string_key_view(obj));
+      else
+        hash_append(hash, obj);
       return (hash_result_t<H>)hash;
     };
   };
 
+  // hash_batch
+
+  namespace detail
+  {
+    // Hashes the keys at `keys` into `codes`, one lane per key. Each step
+    // appends the next byte of every key, so that the lanes' multiply chains
+    // are independent and can execute at the same time. The lanes are
+    // expanded from a pack so that their states can be kept in registers.
+    template<hash_algorithm H, typename T, std::size_t... L>
+    inline void hash_lanes(T const* keys,
+                           hash_result_t<H>* codes,
+                           std::index_sequence<L...>) noexcept
+    {
+      H lanes[sizeof...(L)];
+      for (std::size_t i = 0; i != sizeof(T); ++i)
+        (lanes[L](reinterpret_cast<unsigned char const*>(keys + L) + i, 1), ...);
+      ((codes[L] = (hash_result_t<H>)lanes[L]), ...);
+    }
+  } // namespace detail
+
+  /// Hashes each of `keys` into the corresponding element of `codes`, which
+  /// must be at least as large. The results are the same as computing
+  /// `hash<H>{}(key)` for each key.
+  ///
+  /// When the keys are appended as their object representation (e.g.,
+  /// integers and uniquely represented classes) and `H` consumes one byte at
+  /// a time (e.g., FNV-1a), keys are hashed 8 at a time in interleaved lanes.
+  /// This hides the latency of each lane's multiplications, which otherwise
+  /// form a single dependency chain per key. Block-based algorithms already
+  /// keep several accumulators of their own, and other keys have variable
+  /// length, so those are hashed one at a time.
+  template<hash_algorithm H, hashable_with<typename hash<H>::algorithm_type> T>
+  void hash_batch(std::span<T const> keys, std::span<hash_result_t<H>> codes) noexcept
+  {
+    constexpr std::size_t lanes = 8;
+    std::size_t i = 0;
+    if constexpr (detail::bytewise_hashable<T, H> && !detail::block_hash_algorithm<H> &&
+                  !string_key<T>) {
+      for (; i + lanes <= keys.size(); i += lanes)
+        detail::hash_lanes<H>(keys.data() + i, codes.data() + i,
+                              std::make_index_sequence<lanes>());
+    }
+    hash<H> hash;
+    for (; i != keys.size(); ++i)
+      codes[i] = hash(keys[i]);
+  }
+
 } // namespace lock3
 
 #endif
@@ -0,0 +1,127 @@
+#include "json.hpp"
+#include "json_index.hpp"
+#include "game.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A player whose strings and containers allocate from an arena.
+struct tagged_player
+{
+  std::pmr::string name;
+  game::ratio health;
+  std::pmr::vector<std::pmr::string> tags;
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main()
+{
+  // Quotes escaped by an odd number of backslashes don't end strings, and
+  // structural characters inside strings are not indexed.
+  {
+    std::string text = R"({"a\"{": [1, true], "b\\": "x"})";
+    lock3::json::structural_index index(text);
+    std::vector<std::size_t> expect {0, 1, 6, 7, 9, 10, 11, 13, 17, 18, 20, 24, 25, 27, 29, 30};
+    assert(index.size() == expect.size());
+    for (std::size_t i = 0; i != expect.size(); ++i)
+      assert(index[i] == expect[i]);
+  }
+
+  std::vector<game::player> players;
+  for (int i = 0; i != 100000; ++i)
+    players.push_back({"player" + std::to_string(i), {1000, i % 1000}, {500, i % 500}});
+  lock3::json::buffer buf;
+  lock3::json::writer writer(buf);
+  writer.write(players);
+  std::string text(buf.view());
+
+  auto start = std::chrono::steady_clock::now();
+  lock3::json::structural_index index(text);
+  double index_ms = elapsed_ms(start);
+
+  start = std::chrono::steady_clock::now();
+  std::vector<game::player> from_string;
+  lock3::json::string_input input(text);
+  lock3::json::reader reader(input);
+  reader.read_sequence(from_string);
+  double string_ms = elapsed_ms(start);
+
+  start = std::chrono::steady_clock::now();
+  std::vector<game::player> from_index;
+  lock3::json::indexed_input indexed(text);
+  lock3::json::reader indexed_reader(indexed);
+  indexed_reader.read_sequence(from_index);
+  double indexed_ms = elapsed_ms(start);
+
+  assert(from_index.size() == players.size());
+  for (std::size_t i = 0; i != players.size(); ++i)
+    assert(from_index[i].name == players[i].name);
+
+  // A whole document is read into one arena, with the sequence reserved
+  // from the index.
+  {
+    std::string text = R"([{"name": "andrew", "health": {"max": 10, "current": 5},
+                            "tags": ["mage", "healer"]},
+                           {"name": "bob", "health": {"max": 8, "current": 8},
+                            "tags": []}])";
+    lock3::json::indexed_input input(text);
+    auto doc = lock3::json::read_document<std::pmr::vector<tagged_player>>(input);
+    std::pmr::vector<tagged_player> const& v = doc.value;
+    assert(v.size() == 2 && v.capacity() >= 2);
+    assert(v[0].name == "andrew" && v[0].tags.size() == 2 && v[0].tags[1] == "healer");
+    assert(v[1].tags.empty());
+    assert(v.get_allocator().resource() == doc.arena.get());
+    assert(v[0].name.get_allocator().resource() == doc.arena.get());
+    assert(v[0].tags[0].get_allocator().resource() == doc.arena.get());
+
+    // So do the elements of sequences that don't use an arena themselves.
+    lock3::json::indexed_input plain(text);
+    auto plain_doc = lock3::json::read_document<std::vector<tagged_player>>(plain);
+    assert(plain_doc.value[1].name.get_allocator().resource() == plain_doc.arena.get());
+
+    // Assigning a document destroys the old value before its arena, and
+    // the new value keeps allocating from the arena that comes with it.
+    lock3::json::indexed_input again(text);
+    doc = lock3::json::read_document<std::pmr::vector<tagged_player>>(again);
+    assert(doc.value[0].tags[1] == "healer");
+    assert(doc.value[0].tags[0].get_allocator().resource() == doc.arena.get());
+    lock3::json::indexed_input plain_again(text);
+    plain_doc = lock3::json::read_document<std::vector<tagged_player>>(plain_again);
+    plain_doc.value[1].tags.emplace_back("a tag too long for the small string buffer");
+    assert(plain_doc.value[1].name.get_allocator().resource() == plain_doc.arena.get());
+    assert(plain_doc.value[1].tags[0].get_allocator().resource() == plain_doc.arena.get());
+  }
+
+  // An element that fails to be read is not left in the sequence.
+  {
+    std::string text = R"([{"name": "andrew", "health": {"max": 10, "current": 5},
+                             "magic": {"max": 3, "current": 1}},
+                            {"name": 42}])";
+    lock3::json::indexed_input input(text);
+    lock3::json::reader reader(input);
+    std::vector<game::player> v;
+    bool threw = false;
+    try {
+      reader.read(v);
+    }
+    catch (std::runtime_error const&) {
+      threw = true;
+    }
+    assert(threw && v.size() == 1 && v[0].name == "andrew");
+  }
+
+  std::cout << "index:         " << index_ms << " ms ("
+            << text.size() / index_ms / 1e6 << " GB/s)\n";
+  std::cout << "string_input:  " << string_ms << " ms\n";
+  std::cout << "indexed_input: " << indexed_ms << " ms\n";
+}
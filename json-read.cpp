@@ -1,15 +1,46 @@
 #include "json.hpp"
 #include "game.hpp"
+#include "mapped_file.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <string>
 #include <vector>
 
+// Files at least this large are mapped into memory rather than read.
+constexpr std::size_t map_threshold = 1 << 20;
+
 int main(int argc, char* argv[])
 {
-  std::ifstream is(argv[1]);
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <file.json>\n";
+    return 1;
+  }
+
+  std::ifstream is(argv[1], std::ios::ate);
+  std::streampos end = is.tellg();
+  if (!is || end == std::streampos(-1)) {
+    std::cerr << argv[0] << ": cannot read " << argv[1] << '\n';
+    return 1;
+  }
+  std::size_t size = static_cast<std::size_t>(end);
+
+  std::string text;
+  lock3::mapped_file file;
+  std::string_view contents;
+  if (size >= map_threshold) {
+    file = lock3::mapped_file(argv[1]);
+    contents = file.view();
+  }
+  else {
+    is.seekg(0);
+    text.assign(std::istreambuf_iterator<char>(is), {});
+    contents = text;
+  }
 
-  lock3::json::reader reader(is);
+  lock3::json::string_input input(contents);
+  lock3::json::reader reader(input);
   game::player p1;
   reader.read(p1);
 
@@ -0,0 +1,96 @@
+#include "json.hpp"
+#include "game.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+
+// A message whose strings refer to the input.
+struct message
+{
+  std::string_view from;
+  std::string_view text;
+};
+
+int main()
+{
+  // Write a top-level array and the same records as newline-delimited JSON.
+  lock3::json::buffer array;
+  lock3::json::buffer lines;
+  {
+    lock3::json::writer array_writer(array);
+    lock3::json::writer line_writer(lines);
+    array.push_back('[');
+    for (int i = 0; i != 1000; ++i) {
+      game::player p {"player" + std::to_string(i), {100, i % 100}, {50, i % 50}};
+      if (i != 0)
+        array.push_back(',');
+      array_writer.write(p);
+      line_writer.write(p);
+      lines.push_back('\n');
+    }
+    array.push_back(']');
+  }
+
+  // Each element is read into the same object; the callback sees them in
+  // order.
+  auto check = [](int& count) {
+    return [&count](game::player& p) {
+      assert(p.name == "player" + std::to_string(count));
+      assert(p.health.current == count % 100 && p.magic.current == count % 50);
+      ++count;
+    };
+  };
+
+  {
+    int count = 0;
+    lock3::json::string_input input(array.view());
+    lock3::json::reader reader(input);
+    reader.for_each_element<game::player>(check(count));
+    assert(count == 1000 && reader.at_end());
+  }
+
+  {
+    int count = 0;
+    std::istringstream is(std::string(lines.view()));
+    lock3::json::reader reader(is);
+    reader.for_each_line<game::player>(check(count));
+    assert(count == 1000);
+  }
+
+  {
+    int count = 0;
+    lock3::json::string_input input(std::string_view(" [ ] "));
+    lock3::json::reader reader(input);
+    reader.for_each_element<game::player>(check(count));
+    assert(count == 0 && reader.at_end());
+  }
+
+  // Strings without escapes are views of the input; the others are
+  // decoded into the arena.
+  {
+    std::string text = R"({"from": "alice", "text": "caf\u00e9\n"} {"from": "bob", "text": "hi"})";
+    std::pmr::monotonic_buffer_resource arena;
+    lock3::json::string_input input(text);
+    lock3::json::reader reader(input, &arena);
+    int count = 0;
+    auto in_text = [&](std::string_view s) {
+      return s.data() >= text.data() && s.data() < text.data() + text.size();
+    };
+    reader.for_each_line<message>([&](message& m) {
+      if (count++ == 0) {
+        assert(m.from == "alice" && in_text(m.from));
+        assert(m.text == "caf\xc3\xa9\n" && !in_text(m.text));
+      }
+      else {
+        assert(m.from == "bob" && in_text(m.from));
+        assert(m.text == "hi" && in_text(m.text));
+      }
+    });
+    assert(count == 2);
+  }
+
+  std::cout << "ok\n";
+}
@@ -1,13 +1,99 @@
 #include "json.hpp"
 #include "game.hpp"
 
+#include <array>
+#include <cassert>
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
 #include <vector>
 
+// Returns the time taken to serialize `players` `reps` times with `fn`.
+template<typename F>
+double time_ms(F fn, int reps)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i != reps; ++i)
+    fn();
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count() / reps;
+}
+
 int main(int argc, char* argv[])
 {
   game::player p1 {"andrew", {100, 100}, {50, 50}};
   lock3::json::writer writer(std::cout);
   writer.write(p1);
+  std::cout << '\n';
+
+  // Strings are escaped, and so are the control characters in them.
+  {
+    lock3::json::buffer buf;
+    lock3::json::writer w(buf);
+    w.write(std::string("say \"hi\"\n\\\x01"));
+    assert(buf.view() == R"("say \"hi\"\n\\\u0001")");
+  }
+
+  // Floating point values round-trip in their shortest form.
+  {
+    lock3::json::buffer buf;
+    lock3::json::writer w(buf);
+    w.write(std::vector<double>{0.1, -2.5, 1e300, 1.0 / 0.0});
+    assert(buf.view() == "[0.1,-2.5,1e+300,null]");
+  }
+
+  // Writing past the end of a fixed buffer throws.
+  {
+    std::array<char, 16> storage;
+    lock3::json::fixed_buffer buf(storage);
+    lock3::json::writer w(buf);
+    bool threw = false;
+    try {
+      w.write(p1);
+    }
+    catch (std::length_error const&) {
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  // Serialize a large response through a stream and through buffers.
+  std::vector<game::player> players;
+  for (int i = 0; i != 100000; ++i)
+    players.push_back({"player" + std::to_string(i), {1000, i % 1000}, {500, i % 500}});
+
+  std::string from_stream;
+  double stream_ms = time_ms([&] {
+    std::ostringstream os;
+    lock3::json::writer w(os);
+    w.write(players);
+    from_stream = std::move(os).str();
+  }, 10);
+
+  lock3::json::buffer buf;
+  double buffer_ms = time_ms([&] {
+    buf.clear();
+    lock3::json::writer w(buf);
+    w.write(players);
+  }, 10);
+  assert(buf.view() == from_stream);
+
+  std::vector<char> storage(buf.size());
+  lock3::json::fixed_buffer fixed(storage);
+  double fixed_ms = time_ms([&] {
+    fixed.clear();
+    lock3::json::writer w(fixed);
+    w.write(players);
+  }, 10);
+  assert(fixed.view() == from_stream);
+
+  std::string flushed;
+  buf.flush(flushed);
+  assert(flushed == from_stream && buf.size() == 0);
+
+  std::cout << "ostringstream: " << stream_ms << " ms\n";
+  std::cout << "buffer:        " << buffer_ms << " ms\n";
+  std::cout << "fixed_buffer:  " << fixed_ms << " ms\n";
 }
@@ -2,9 +2,28 @@
 #define LOCK3_JSON_HPP
 
 #include "concepts.hpp"
+#include "perfect_hash.hpp"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <system_error>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <experimental/meta>
 #include <experimental/compiler>
@@ -13,10 +32,315 @@
 
 namespace lock3::json
 {
-  /// Writes JSON-formatted values to an output stream. This is a CRTP class,
-  /// meaning it is parameterized by its derived class. Doing so means that
-  /// the derived class can provide additional overrides of write_value()
-  /// for application-specific types.
+  namespace detail
+  {
+    // Output that characters are appended to directly, rather than through
+    // a stream.
+    template<typename Out>
+    concept char_buffer =
+      requires (Out& out, char const* p, std::size_t n) {
+        out.push_back(*p);
+        out.append(p, n);
+      };
+
+    // Enough characters for any integer or shortest round-trip double.
+    constexpr std::size_t max_number_length = 32;
+
+    namespace meta = std::experimental::meta;
+
+    // The text written before the value of the data member `M`: its quoted
+    // name and a colon, preceded by '{' for the first member of a class and
+    // by ',' for the others. This is computed at compile time, so writing a
+    // key is a single copy of a constant string.
+    template<meta::info M, bool First>
+    struct member_key
+    {
+      static constexpr std::size_t length =
+        lock3::detail::constexpr_length(meta::name_of(M)) + 4;
+
+      static constexpr std::array<char, length> chars = [] {
+        std::array<char, length> result {};
+        result[0] = First ? '{' : ',';
+        result[1] = '"';
+        std::copy_n(meta::name_of(M), length - 4, result.begin() + 2);
+        result[length - 2] = '"';
+        result[length - 1] = ':';
+        return result;
+      }();
+
+      static constexpr std::string_view text {chars.data(), length};
+    };
+
+    // The names of the data members of `T`, in declaration order, and a
+    // perfect hash table mapping each name to its index.
+    template<typename T>
+    struct member_names
+    {
+      static constexpr std::size_t count = [] {
+        return size(meta::members_of(^T, meta::is_data_member));
+      }();
+
+      static constexpr std::array<std::string_view, count> names = [] {
+        std::array<std::string_view, count> result {};
+        std::size_t i = 0;
+        template for (constexpr meta::info member : meta::members_of(^T, meta::is_data_member))
+          result[i++] = meta::name_of(member);
+        return result;
+      }();
+
+      static constexpr perfect_hash<count> table {names};
+    };
+
+    // Input whose characters are in memory, between `first` and `last`,
+    // and scanned with the pointer `pos` (see string_input).
+    template<typename In>
+    concept contiguous_input =
+      requires (In& in) {
+        { in.first } -> std::convertible_to<char const*>;
+        { in.pos } -> std::convertible_to<char const*>;
+        { in.last } -> std::convertible_to<char const*>;
+      };
+
+    // Contiguous input with a structural index: the sorted positions of the
+    // characters that can follow whitespace (see json_index.hpp). `next` is
+    // the first entry that may be at or after `pos`.
+    template<typename In>
+    concept structurally_indexed =
+      contiguous_input<In> &&
+      requires (In& in) {
+        { in.index[in.next] } -> std::convertible_to<std::size_t>;
+        { in.index.size() } -> std::convertible_to<std::size_t>;
+      };
+
+    // Character classes of the JSON grammar. Unlike the <cctype> functions,
+    // these don't depend on the locale.
+    constexpr bool is_space(char c) noexcept
+    {
+      return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    constexpr bool is_digit(char c) noexcept
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    constexpr bool is_alpha(char c) noexcept
+    {
+      return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    // Satisfied if `T` allocates with a polymorphic allocator (e.g.,
+    // std::pmr::string or std::pmr::vector).
+    template<typename T>
+    concept pmr_allocated =
+      std::uses_allocator_v<T, std::pmr::polymorphic_allocator<>>;
+
+    // Rebuild `obj` so that it, and recursively its members, allocate from
+    // `arena` if they use polymorphic allocators. Objects are rebuilt empty.
+    //
+    // Members are destroyed and constructed in place, because assigning a
+    // container with a different allocator does not change its allocator.
+    // Uses-allocator construction passes the allocator however `T` takes
+    // it, first or last.
+    template<typename T>
+    void adopt_allocator(T& obj, std::pmr::memory_resource* arena)
+    {
+      if constexpr (pmr_allocated<T>) {
+        std::destroy_at(&obj);
+        std::uninitialized_construct_using_allocator(&obj, std::pmr::polymorphic_allocator<>(arena));
+      }
+      else if constexpr (basic_data_type<T>) {
+        constexpr auto members = meta::members_of(^T, meta::is_data_member);
+        template for (constexpr meta::info member : members)
+          adopt_allocator(obj.[:member:], arena);
+      }
+    }
+
+    // Append the UTF-8 encoding of the code point `code` to `str`.
+    inline void append_utf8(std::string& str, std::uint32_t code)
+    {
+      if (code < 0x80) {
+        str += char(code);
+      }
+      else if (code < 0x800) {
+        str += char(0xc0 | (code >> 6));
+        str += char(0x80 | (code & 0x3f));
+      }
+      else if (code < 0x10000) {
+        str += char(0xe0 | (code >> 12));
+        str += char(0x80 | ((code >> 6) & 0x3f));
+        str += char(0x80 | (code & 0x3f));
+      }
+      else {
+        str += char(0xf0 | (code >> 18));
+        str += char(0x80 | ((code >> 12) & 0x3f));
+        str += char(0x80 | ((code >> 6) & 0x3f));
+        str += char(0x80 | (code & 0x3f));
+      }
+    }
+
+    // Write `n` characters to a stream or container.
+    template<typename Sink>
+    void flush_chars(Sink& sink, char const* p, std::size_t n)
+    {
+      if constexpr (requires { sink.write(p, std::streamsize(n)); })
+        sink.write(p, std::streamsize(n));
+      else
+        sink.insert(sink.end(), p, p + n);
+    }
+  } // namespace detail
+
+  /// A growable, contiguous output buffer for JSON writers. Writing to a
+  /// buffer avoids the per-token overhead of streams; the result can be
+  /// viewed in place or flushed to a stream or container when done.
+  class buffer
+  {
+  public:
+    buffer() = default;
+
+    explicit buffer(std::size_t capacity)
+    {
+      reserve(capacity);
+    }
+
+    /// Ensures room for `n` more characters.
+    void reserve(std::size_t n)
+    {
+      if (cap - len < n)
+        grow(n);
+    }
+
+    void push_back(char c)
+    {
+      if (len == cap)
+        grow(1);
+      chars[len++] = c;
+    }
+
+    void append(char const* p, std::size_t n)
+    {
+      reserve(n);
+      std::memcpy(chars.get() + len, p, n);
+      len += n;
+    }
+
+    char const* data() const noexcept
+    {
+      return chars.get();
+    }
+
+    std::size_t size() const noexcept
+    {
+      return len;
+    }
+
+    std::string_view view() const noexcept
+    {
+      return {chars.get(), len};
+    }
+
+    void clear() noexcept
+    {
+      len = 0;
+    }
+
+    /// Writes the contents of the buffer to `sink` (a stream or container
+    /// of characters) and clears it.
+    template<typename Sink>
+    void flush(Sink& sink)
+    {
+      detail::flush_chars(sink, data(), size());
+      clear();
+    }
+
+  private:
+    void grow(std::size_t n)
+    {
+      std::size_t new_cap = std::max(cap * 2, std::max(len + n, std::size_t(256)));
+      std::unique_ptr<char[]> new_chars(new char[new_cap]);
+      if (len != 0)
+        std::memcpy(new_chars.get(), chars.get(), len);
+      chars = std::move(new_chars);
+      cap = new_cap;
+    }
+
+    std::unique_ptr<char[]> chars;
+    std::size_t len = 0;
+    std::size_t cap = 0;
+  };
+
+  /// An output buffer over caller-provided storage. Writing past the end of
+  /// the storage throws std::length_error.
+  class fixed_buffer
+  {
+  public:
+    explicit fixed_buffer(std::span<char> storage)
+      : chars(storage)
+    { }
+
+    void push_back(char c)
+    {
+      if (len == chars.size())
+        overflow();
+      chars[len++] = c;
+    }
+
+    void append(char const* p, std::size_t n)
+    {
+      if (chars.size() - len < n)
+        overflow();
+      std::memcpy(chars.data() + len, p, n);
+      len += n;
+    }
+
+    char const* data() const noexcept
+    {
+      return chars.data();
+    }
+
+    std::size_t size() const noexcept
+    {
+      return len;
+    }
+
+    std::string_view view() const noexcept
+    {
+      return {chars.data(), len};
+    }
+
+    void clear() noexcept
+    {
+      len = 0;
+    }
+
+    /// Writes the contents of the buffer to `sink` (a stream or container
+    /// of characters) and clears it.
+    template<typename Sink>
+    void flush(Sink& sink)
+    {
+      detail::flush_chars(sink, data(), size());
+      clear();
+    }
+
+  private:
+    [[noreturn]] static void overflow()
+    {
+      throw std::length_error("lock3::json::fixed_buffer: overflow");
+    }
+
+    std::span<char> chars;
+    std::size_t len = 0;
+  };
+
+  /// Writes JSON-formatted values to an output stream or buffer. This is a
+  /// CRTP class, meaning it is parameterized by its derived class. Doing so
+  /// means that the derived class can provide additional overrides of
+  /// write_value() for application-specific types.
+  ///
+  /// Characters are written with `put()`, which appends directly to buffers
+  /// (see json::buffer) and uses unformatted output for streams. Numbers
+  /// are formatted with std::to_chars; floating point values are written in
+  /// their shortest round-trip form.
   template<typename Derived, typename Out>
   struct basic_writer
   {
@@ -36,75 +360,139 @@ namespace lock3::json
       return static_cast<Derived&>(*this);
     }
 
+    void put(char c)
+    {
+      if constexpr (detail::char_buffer<Out>)
+        out.push_back(c);
+      else
+        out.put(c);
+    }
+
+    void put(std::string_view str)
+    {
+      if constexpr (detail::char_buffer<Out>)
+        out.append(str.data(), str.size());
+      else
+        out.write(str.data(), str.size());
+    }
+
+    template<typename T>
+    void put_number(T n)
+    {
+      char buf[detail::max_number_length];
+      auto result = std::to_chars(buf, buf + sizeof(buf), n);
+      put(std::string_view(buf, result.ptr - buf));
+    }
+
     void write_value(bool b)
     {
-      out << (b ? "true" : "false");
+      put(b ? "true" : "false");
     }
 
     template<std::integral T>
     void write_value(T n)
     {
-      out << n;
+      put_number(n);
     }
 
+    /// Write floating point values. JSON cannot represent infinities and
+    /// NaNs, so these are written as null.
     template<std::floating_point T>
     void write_value(T n)
     {
-      out << n;
+      if (std::isfinite(n))
+        put_number(n);
+      else
+        put("null");
     }
 
-    void write_value(std::string const& str)
+    /// Write strings, escaping quotes, backslashes and control characters.
+    /// Runs of characters that need no escaping are written at once.
+    void write_string(std::string_view str)
     {
-      out << '"' << str << '"';
+      put('"');
+      std::size_t first = 0;
+      for (std::size_t i = 0; i != str.size(); ++i) {
+        unsigned char c = str[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+          continue;
+        put(str.substr(first, i - first));
+        put_escape(c);
+        first = i + 1;
+      }
+      put(str.substr(first));
+      put('"');
+    }
+
+    void put_escape(unsigned char c)
+    {
+      switch (c) {
+      case '"': return put("\\\"");
+      case '\\': return put("\\\\");
+      case '\b': return put("\\b");
+      case '\f': return put("\\f");
+      case '\n': return put("\\n");
+      case '\r': return put("\\r");
+      case '\t': return put("\\t");
+      default: {
+        constexpr char const* digits = "0123456789abcdef";
+        char buf[6] = {'\\', 'u', '0', '0', digits[c >> 4], digits[c & 0xf]};
+        return put(std::string_view(buf, 6));
+      }
+      }
     }
 
     template<std::ranges::range R>
     void write_array(R const& range)
     {
-      out << '[';
-      auto first = std::begin(range);
-      auto last = std::end(range);
-      for (auto iter = first; iter != last; ++iter) {
-        derived().write(*iter);
-        if (std::next(iter) != last)
-          out << ',';
+      put('[');
+      bool first = true;
+      for (auto const& elem : range) {
+        if (!first)
+          put(',');
+        derived().write(elem);
+        first = false;
       }
-      out << ']';
+      put(']');
     }
 
-    /// Write the members of a simple class.
+    /// Write the members of a simple class. The text before each value,
+    /// e.g. `{"name":` or `,"health":`, is a single precomputed string (see
+    /// detail::member_key).
     ///
     /// TODO: This does not handle base classes.
     template<basic_data_type T>
     void write_class(T const& obj)
     {
       namespace meta = std::experimental::meta;
-      out << '{';
       constexpr auto members = meta::members_of(^T, meta::is_data_member);
       constexpr std::size_t num = size(members);
-      std::size_t count = 0;
-      template for (constexpr meta::info member : members) {
-        out << '"' << meta::name_of(member) << '"' << ':';
+      if constexpr (num == 0)
+        put('{');
+      template for (constexpr std::size_t I : ints(num)) {
+        constexpr meta::info member = *std::next(members.begin(), I);
+        put(detail::member_key<member, I == 0>::text);
         derived().write(obj.[:member:]);
-        if (++count != num)
-          out << ',';
       }
-      out << '}';
+      put('}');
     }
 
-    /// Write the value of user-defined types (and arrays).
+    /// Write the value of strings, ranges, user-defined types (and arrays).
     template<typename T>
+      requires class_type<T> || std::is_array_v<T>
     void write_value(T const& t)
     {
-      if constexpr (std::ranges::range<T>)
+      if constexpr (string_like<T> || c_string<T>)
+        return write_string(string_key_view(t));
+      else if constexpr (std::ranges::range<T>)
         return write_array(t);
-      if constexpr (basic_data_type<T>)
+      else if constexpr (basic_data_type<T>)
         return write_class(t);
       else
         static_assert(dependent_false<T>(), "unreachable");
     }
 
-    /// Write the JSON-formatted version of `t` to the output stream.
+    /// Write the JSON-formatted version of `t` to the output.
     template<typename T>
     void write(T const& t)
     {
@@ -123,15 +511,42 @@ namespace lock3::json
     { }
   };
 
-  /// Reads JSON-formatted values from an input stream. This is a CRTP class,
-  /// meaning it is parameterized by its derived class. Doing so means that
-  /// the derived class can provide additional overrides of read_value()
-  /// for application-specific types.
+  /// Input for JSON readers from a contiguous range of characters (e.g., a
+  /// std::string or the contents of a file). Readers scan this input with
+  /// pointers instead of reading a character at a time, and compute line
+  /// and column numbers only when reporting an error.
+  struct string_input
+  {
+    explicit string_input(std::string_view str)
+      : first(str.data()), pos(str.data()), last(str.data() + str.size())
+    { }
+
+    string_input(char const* first, char const* last)
+      : first(first), pos(first), last(last)
+    { }
+
+    /// The start of the input.
+    char const* first;
+
+    /// The next character to be read.
+    char const* pos;
+
+    /// The end of the input.
+    char const* last;
+  };
+
+  /// Reads JSON-formatted values from an input stream, a string_input, or
+  /// an indexed_input (see json_index.hpp).
+  /// This is a CRTP class, meaning it is parameterized by its derived class.
+  /// Doing so means that the derived class can provide additional overrides
+  /// of read_value() for application-specific types.
   ///
   /// This is a type-directed parser. That is, the type of object provided to
   /// `read()` will determine how the input is parsed.
   ///
-  /// NOTE: This is not an efficient parser.
+  /// Tokens are scanned as string views. With a string_input, these refer
+  /// to the input itself; with a stream, they refer to a buffer that is
+  /// reused for each token. Numbers are converted with std::from_chars.
   template<typename Derived, typename In>
   struct basic_reader
   {
@@ -139,6 +554,10 @@ namespace lock3::json
       : in(in)
     { }
 
+    basic_reader(In& in, std::pmr::memory_resource* arena)
+      : in(in), arena(arena)
+    { }
+
     /// Returns this cast as the derived class.
     Derived const& derived() const
     {
@@ -154,29 +573,52 @@ namespace lock3::json
     [[noreturn]]
     void error(std::string const& str)
     {
+      if constexpr (detail::contiguous_input<In>) {
+        auto rfirst = std::make_reverse_iterator(in.pos);
+        auto rlast = std::make_reverse_iterator(in.first);
+        line = 1 + int(std::count(in.first, in.pos, '\n'));
+        column = 1 + int(in.pos - std::find(rfirst, rlast, '\n').base());
+      }
       std::stringstream ss;
       ss << "error @ " << line << ':' << column << ": " << str;
       throw std::runtime_error(ss.str());
     }
 
+    /// Returns the next character, or 0 at the end of the input.
+    char peek()
+    {
+      if constexpr (detail::contiguous_input<In>) {
+        return in.pos != in.last ? *in.pos : 0;
+      }
+      else {
+        auto c = in.peek();
+        return c == In::traits_type::eof() ? 0 : char(c);
+      }
+    }
+
     char get_char()
     {
-      char c = in.get();
-      if (c == '\n') {
-        ++line;
-        column = 1;
+      if constexpr (detail::contiguous_input<In>) {
+        return in.pos != in.last ? *in.pos++ : 0;
       }
       else {
-        ++column;
+        char c = in.get();
+        if (c == '\n') {
+          ++line;
+          column = 1;
+        }
+        else {
+          ++column;
+        }
+        return c;
       }
-      return c;
     }
 
     char expect_char(char c)
     {
-      if (in.peek() != c) {
+      if (peek() != c) {
         std::stringstream ss;
-        ss << "expected '" << c << "' but got '" << (char)in.peek() << "'";
+        ss << "expected '" << c << "' but got '" << peek() << "'";
         error(ss.str());
       }
       get_char();
@@ -191,84 +633,244 @@ namespace lock3::json
       return r;
     }
 
+    // With a structural index, the next non-whitespace character is the
+    // next entry of the index.
     void skip_space()
     {
-      while (char c = in.peek()) {
-        if (!std::isspace(c))
-          break;
-        get_char();
+      if constexpr (detail::structurally_indexed<In>) {
+        if (in.pos == in.last || !detail::is_space(*in.pos))
+          return;
+        std::size_t offset = in.pos - in.first;
+        while (in.next != in.index.size() && in.index[in.next] < offset)
+          ++in.next;
+        in.pos = in.next != in.index.size() ? in.first + in.index[in.next] : in.last;
+      }
+      else if constexpr (detail::contiguous_input<In>) {
+        while (in.pos != in.last && detail::is_space(*in.pos))
+          ++in.pos;
+      }
+      else {
+        while (detail::is_space(peek()))
+          get_char();
       }
     }
 
-    std::string scan_word()
+    // Tokens are built with start_token(), take() and token_text(). Stream
+    // input copies the characters of the token into `token`.
+
+    void start_token()
+    {
+      if constexpr (detail::contiguous_input<In>)
+        token_first = in.pos;
+      else
+        token.clear();
+    }
+
+    void take()
+    {
+      if constexpr (detail::contiguous_input<In>)
+        ++in.pos;
+      else
+        token += get_char();
+    }
+
+    void take_digits()
+    {
+      while (detail::is_digit(peek()))
+        take();
+    }
+
+    std::string_view token_text() const
+    {
+      if constexpr (detail::contiguous_input<In>)
+        return std::string_view(token_first, in.pos - token_first);
+      else
+        return token;
+    }
+
+    std::string_view scan_word()
     {
-      std::string s;
       skip_space();
-      while (char c = in.peek()) {
-        if (!std::isalpha(c))
-          break;
-        s += get_char();
-      }
+      start_token();
+      while (detail::is_alpha(peek()))
+        take();
+      std::string_view s = token_text();
       skip_space();
       return s;
     }
 
-    void scan_number(std::string& s)
+    // Scan the integer part of a number: -?(0|[1-9][0-9]*).
+    void scan_integer_part()
     {
-      while (char c = in.peek()) {
-        if (!std::isdigit(c))
-          break;
-        s += get_char();
-      }
+      if (peek() == '-')
+        take();
+      if (peek() == '0')
+        take();
+      else if (detail::is_digit(peek()))
+        take_digits();
+      else
+        error("expected number");
     }
 
-    // TODO: Support hex numbers?
-    std::string scan_integer()
+    std::string_view scan_integer()
     {
-      std::string s;
       skip_space();
-      scan_number(s);
-      if (s.empty())
-        error("expected integer value");
+      start_token();
+      scan_integer_part();
+      std::string_view s = token_text();
       skip_space();
       return s;
     }
 
-    // FIXME: Make this conform to the floating point input.
-    std::string scan_float()
+    // Scan a number: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    std::string_view scan_float()
     {
-      std::string s;
       skip_space();
-      scan_number(s);
-        error("expected floating point value");
-      if (in.peek() == '.')
-        s += get_char();
-      scan_number(s);
+      start_token();
+      scan_integer_part();
+      if (peek() == '.') {
+        take();
+        if (!detail::is_digit(peek()))
+          error("expected digit after '.'");
+        take_digits();
+      }
+      if (peek() == 'e' || peek() == 'E') {
+        take();
+        if (peek() == '+' || peek() == '-')
+          take();
+        if (!detail::is_digit(peek()))
+          error("expected digit in exponent");
+        take_digits();
+      }
+      std::string_view s = token_text();
       skip_space();
       return s;
     }
 
-    // FIXME: Do a better job with escape characters.
-    std::string scan_string()
+    // With contiguous input, a string without escapes is returned as a view
+    // of the input. Otherwise, its characters are decoded into `token`.
+    // With a structural index, the closing quote is the entry after the
+    // opening one.
+    std::string_view scan_string()
     {
-      std::string s;
       skip_space();
       expect_char('"');
-      while (char c = in.peek()) {
+      token.clear();
+      if constexpr (detail::structurally_indexed<In>) {
+        std::size_t open = in.pos - 1 - in.first;
+        while (in.next != in.index.size() && in.index[in.next] < open)
+          ++in.next;
+        if (in.next + 1 < in.index.size() && in.index[in.next] == open) {
+          char const* close = in.first + in.index[in.next + 1];
+          if (*close == '"' && !std::memchr(in.pos, '\\', close - in.pos)) {
+            std::string_view s(in.pos, close - in.pos);
+            in.pos = close + 1;
+            in.next += 2;
+            skip_space();
+            return s;
+          }
+        }
+      }
+      else if constexpr (detail::contiguous_input<In>) {
+        char const* p = in.pos;
+        while (p != in.last && *p != '"' && *p != '\\')
+          ++p;
+        if (p != in.last && *p == '"') {
+          std::string_view s(in.pos, p - in.pos);
+          in.pos = p + 1;
+          skip_space();
+          return s;
+        }
+        // Keep the characters before the first escape.
+        token.assign(in.pos, p);
+        in.pos = p;
+      }
+      while (true) {
+        char c = peek();
         if (c == '"')
           break;
+        if (c == 0)
+          error("unterminated string");
+        get_char();
         if (c == '\\')
-          get_char();
-        s += get_char();
+          scan_escape();
+        else
+          token += c;
       }
       expect_char('"');
       skip_space();
-      return s;
+      return token;
+    }
+
+    // Decode the escape sequence following a backslash into `token`.
+    // Surrogate pairs are combined, and code points are encoded as UTF-8.
+    void scan_escape()
+    {
+      switch (char c = get_char()) {
+      case '"':
+      case '\\':
+      case '/':
+        token += c;
+        return;
+      case 'b': token += '\b'; return;
+      case 'f': token += '\f'; return;
+      case 'n': token += '\n'; return;
+      case 'r': token += '\r'; return;
+      case 't': token += '\t'; return;
+      case 'u': {
+        std::uint32_t code = scan_hex4();
+        if (code >= 0xdc00 && code < 0xe000)
+          error("unpaired low surrogate");
+        if (code >= 0xd800 && code < 0xdc00) {
+          if (get_char() != '\\' || get_char() != 'u')
+            error("expected low surrogate");
+          std::uint32_t low = scan_hex4();
+          if (low < 0xdc00 || low >= 0xe000)
+            error("expected low surrogate");
+          code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+        }
+        detail::append_utf8(token, code);
+        return;
+      }
+      default:
+        error("invalid escape sequence");
+      }
+    }
+
+    // Scan the four hex digits of a \u escape.
+    std::uint32_t scan_hex4()
+    {
+      std::uint32_t code = 0;
+      for (int i = 0; i != 4; ++i) {
+        char c = get_char();
+        std::uint32_t digit;
+        if (c >= '0' && c <= '9')
+          digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+          digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+          digit = c - 'A' + 10;
+        else
+          error("expected hex digit");
+        code = code * 16 + digit;
+      }
+      return code;
+    }
+
+    // Convert the number in `s` to `n`.
+    template<typename T>
+    void parse_number(std::string_view s, T& n)
+    {
+      auto result = std::from_chars(s.data(), s.data() + s.size(), n);
+      if (result.ec == std::errc::result_out_of_range)
+        error("number out of range");
+      if (result.ec != std::errc() || result.ptr != s.data() + s.size())
+        error("invalid number");
     }
 
     void read_value(bool& b)
     {
-      std::string s = scan_word();
+      std::string_view s = scan_word();
       if (s == "true")
         b = true;
       else if (s == "false")
@@ -280,52 +882,237 @@ namespace lock3::json
     template<std::integral T>
     void read_value(T& n)
     {
-      std::string num = scan_integer();
-      n = std::stoll(num);
+      parse_number(scan_integer(), n);
     }
 
     template<std::floating_point T>
     void read_value(T& n)
     {
-      std::string num = scan_float();
-      n = std::stod(num);
+      parse_number(scan_float(), n);
     }
 
-    void read_value(std::string& str)
+    /// Read strings, including those with other allocators (e.g.,
+    /// std::pmr::string), which keep their allocator.
+    template<typename Traits, typename Alloc>
+    void read_value(std::basic_string<char, Traits, Alloc>& str)
     {
-      str = scan_string();
+      str.assign(scan_string());
+    }
+
+    /// Read a string as a view of the input, without copying it. This
+    /// requires contiguous input that outlives the view. Strings with escapes
+    /// can't be viewed in the input; they are decoded and copied into the
+    /// reader's arena, which must be set (see `arena`).
+    void read_value(std::string_view& str)
+    {
+      static_assert(detail::contiguous_input<In>,
+                    "string views require contiguous input");
+      std::string_view s = scan_string();
+      if (s.data() != token.data()) {
+        str = s;
+        return;
+      }
+      if (!arena)
+        error("no arena for a string with escapes");
+      char* p = static_cast<char*>(arena->allocate(s.size(), 1));
+      std::memcpy(p, s.data(), s.size());
+      str = std::string_view(p, s.size());
     }
 
     // TODO: There's another version where the size of the of sequence is
     // fixed at compile-time (e.g., array). Presumably, we could do something
     // similar for tuples also.
+    //
+    // The sequence is cleared first, so that reading into an object that is
+    // reused (see for_each_element) replaces its elements. Elements are
+    // constructed in place and then read; if reading one fails, it is
+    // removed. Elements of a sequence with a polymorphic allocator allocate
+    // from the same resource as the sequence, and elements of other
+    // sequences from the reader's arena, if it has one.
+    //
+    // With a structural index, the outermost sequence being read is
+    // reserved for the number of elements. Counting scans the index to the
+    // closing bracket, so sequences nested in it are not counted; otherwise
+    // each level of nesting would scan the same positions again.
     template<back_insertion_sequence S>
     void read_sequence(S& seq)
     {
+      seq.clear();
       expect_punctuation('[');
+      if (peek() == ']') {
+        expect_punctuation(']');
+        return;
+      }
+      if constexpr (detail::structurally_indexed<In> &&
+                    requires (std::size_t n) { seq.reserve(n); }) {
+        if (sequence_depth == 0)
+          seq.reserve(count_elements());
+      }
+      ++sequence_depth;
+      try {
+        read_elements(seq);
+      }
+      catch (...) {
+        --sequence_depth;
+        throw;
+      }
+      --sequence_depth;
+    }
+
+    // Read the elements of a non-empty sequence and its closing bracket.
+    template<back_insertion_sequence S>
+    void read_elements(S& seq)
+    {
+      while (true) {
+        if constexpr (requires { seq.emplace_back(); }) {
+          seq.emplace_back();
+          try {
+            if constexpr (detail::pmr_allocated<S>)
+              detail::adopt_allocator(seq.back(), seq.get_allocator().resource());
+            else if (arena)
+              detail::adopt_allocator(seq.back(), arena);
+            derived().read(seq.back());
+          }
+          catch (...) {
+            seq.pop_back();
+            throw;
+          }
+        }
+        else {
+          container_value_t<S> obj;
+          derived().read(obj);
+          seq.push_back(std::move(obj));
+        }
+        if (peek() == ']')
+          break;
+        expect_punctuation(',');
+      }
+      expect_punctuation(']');
+    }
+
+    // Returns the number of elements of the array whose opening bracket was
+    // just read, by counting the commas at its top level in the structural
+    // index. The array must not be empty. This takes time proportional to
+    // the number of structural characters in the array.
+    std::size_t count_elements()
+      requires detail::structurally_indexed<In>
+    {
+      std::size_t open = in.pos - 1 - in.first;
+      std::size_t k = in.next;
+      while (k != in.index.size() && in.index[k] <= open)
+        ++k;
+      std::size_t depth = 0;
+      std::size_t count = 1;
+      for (; k != in.index.size(); ++k) {
+        switch (in.first[in.index[k]]) {
+        case '[':
+        case '{':
+          ++depth;
+          break;
+        case ']':
+        case '}':
+          if (depth == 0)
+            return count;
+          --depth;
+          break;
+        case ',':
+          if (depth == 0)
+            ++count;
+          break;
+        default:
+          break;
+        }
+      }
+      return count;
+    }
+
+    /// Returns true if nothing but whitespace remains in the input.
+    bool at_end()
+    {
+      skip_space();
+      if constexpr (detail::contiguous_input<In>)
+        return in.pos == in.last;
+      else
+        return in.peek() == In::traits_type::eof();
+    }
+
+    /// Read a JSON array one element at a time, calling `f` with each
+    /// element, as an lvalue of type `T`.
+    ///
+    /// The same object is read into for every element, so the storage it
+    /// owns (e.g., the capacity of its strings) is reused, and memory use
+    /// does not grow with the number of elements. `f` may move from the
+    /// element.
+    template<typename T, typename F>
+    void for_each_element(F f)
+    {
+      T obj {};
+      expect_punctuation('[');
+      if (peek() == ']') {
+        expect_punctuation(']');
+        return;
+      }
       while (true) {
-        container_value_t<S> obj;
         derived().read(obj);
-        seq.push_back(obj);
-        if (in.peek() == ']')
+        f(obj);
+        if (peek() == ']')
           break;
         expect_punctuation(',');
       }
       expect_punctuation(']');
     }
 
+    /// Read newline-delimited JSON (a sequence of values separated by
+    /// whitespace) to the end of the input, calling `f` with each value, as
+    /// an lvalue of type `T`. As with for_each_element(), the same object is
+    /// reused for every value.
+    template<typename T, typename F>
+    void for_each_line(F f)
+    {
+      T obj {};
+      while (!at_end()) {
+        derived().read(obj);
+        f(obj);
+      }
+    }
+
+    /// Read the member of `obj` named `name` and return its index.
+    ///
+    /// Names are looked up in a perfect hash table built from the member
+    /// names at compile time. Objects are usually written with their members
+    /// in declaration order, so the member at index `expected` is checked
+    /// first; when it matches, no hashing is needed.
     template<typename T>
-    void read_member(T& obj, std::string const& name)
+    std::size_t read_member(T& obj, std::string_view name, std::size_t expected = 0)
+    {
+      namespace meta = std::experimental::meta;
+      using M = detail::member_names<T>;
+      std::size_t index;
+      if (expected < M::count && M::names[expected] == name)
+        index = expected;
+      else
+        index = M::table.find(name);
+      if (index == perfect_hash<M::count>::npos) {
+        std::stringstream ss;
+        ss << "no member named '" << name << "' in '" << meta::name_of(^T) << "'";
+        error(ss.str());
+      }
+      read_member_at(obj, index);
+      return index;
+    }
+
+    // Read the data member of `obj` at `index`.
+    template<typename T>
+    void read_member_at(T& obj, std::size_t index)
     {
       namespace meta = std::experimental::meta;
       constexpr auto members = meta::members_of(^T, meta::is_data_member);
-      template for (constexpr meta::info member : members) {
-        if (meta::name_of(member) == name)
+      constexpr std::size_t num = size(members);
+      template for (constexpr std::size_t I : ints(num)) {
+        constexpr meta::info member = *std::next(members.begin(), I);
+        if (index == I)
           return derived().read(obj.[:member:]);
       }
-      std::stringstream ss;
-      ss << "no member named '" << name << "' in '" << meta::name_of(^T) << "'";
-      error(ss.str());
     }
 
     /// Read the members of a simple class.
@@ -341,12 +1128,13 @@ namespace lock3::json
       std::size_t count = 0;
 
       expect_punctuation('{');
+      std::size_t next = 0;
       while (true) {
-        std::string key = scan_string();
+        std::string_view key = scan_string();
         expect_punctuation(':');
-        read_member(obj, key);
+        next = read_member(obj, key, next) + 1;
         ++count;
-        if (in.peek() == '}')
+        if (peek() == '}')
           break;
         expect_punctuation(',');
       }
@@ -356,13 +1144,13 @@ namespace lock3::json
         error("incomplete initialization of object");
       }
 
-    /// Write the value of user-defined types (and arrays).
+    /// Read the value of sequences and user-defined types.
     template<typename T>
     void read_value(T& t)
     {
-      // if constexpr (std::ranges::range<T>)
-      //   return write_array(t);
-      if constexpr (basic_data_type<T>)
+      if constexpr (back_insertion_sequence<T>)
+        return read_sequence(t);
+      else if constexpr (basic_data_type<T>)
         return read_class(t);
       else
         static_assert(dependent_false<T>(), "unreachable");
@@ -378,6 +1166,21 @@ namespace lock3::json
     In& in;
     int line = 1;
     int column = 1;
+
+    /// Memory for the values read that can't refer to the input, such as
+    /// string views of strings with escapes. This is not owned by the
+    /// reader, and must outlive the values read.
+    std::pmr::memory_resource* arena = nullptr;
+
+    /// The characters of the current token, for stream input and strings
+    /// with escapes.
+    std::string token;
+
+    /// The start of the current token, for contiguous input.
+    char const* token_first = nullptr;
+
+    /// The number of sequences being read, one inside another.
+    std::size_t sequence_depth = 0;
   };
 
   /// A simple JSON reader that handles classes without indirection.
@@ -387,8 +1190,75 @@ namespace lock3::json
     reader(In& in)
       : basic_reader<reader<In>, In>(in)
     { }
+
+    reader(In& in, std::pmr::memory_resource* arena)
+      : basic_reader<reader<In>, In>(in, arena)
+    { }
   };
 
+  /// A value read from JSON, together with the arena that holds its memory.
+  /// See read_document().
+  template<typename T>
+  struct document
+  {
+    /// Create an empty value in a new arena whose first block is `initial`
+    /// bytes.
+    explicit document(std::size_t initial)
+      : arena(std::make_unique<std::pmr::monotonic_buffer_resource>(initial)), value()
+    {
+      detail::adopt_allocator(value, arena.get());
+    }
+
+    document(document&&) = default;
+
+    /// Replace this document with `other`. The value is destroyed before its
+    /// arena is released, and the value of `other` is moved together with
+    /// its allocator, so that it still allocates from the arena it now
+    /// shares a document with. (Assigning the members in order would
+    /// release the arena first, and assigning a polymorphic container would
+    /// copy into the old arena.)
+    document& operator=(document&& other) noexcept
+    {
+      if (this != &other) {
+        std::destroy_at(&value);
+        arena = std::move(other.arena);
+        std::construct_at(&value, std::move(other.value));
+      }
+      return *this;
+    }
+
+    /// The memory of the value. This is declared first, so that it is
+    /// released after the value is destroyed.
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+
+    /// The value read.
+    T value;
+  };
+
+  /// Read a value of type `T` from `in` into a new arena. Strings and
+  /// containers of the value that use polymorphic allocators (e.g.,
+  /// std::pmr::string and std::pmr::vector, at any depth), and string
+  /// views of strings with escapes, are allocated from the arena. The whole
+  /// object graph then occupies a few large blocks, and its memory is
+  /// released at once when the document is destroyed.
+  ///
+  /// With contiguous input, the arena's first block is the size of the
+  /// input, up to `max_initial` bytes. Most of a large document is often
+  /// scalars and string views that never touch the arena, so the arena
+  /// grows from there only as needed.
+  template<typename T, typename In>
+  document<T> read_document(In& in, std::size_t max_initial = std::size_t(4) << 20)
+  {
+    std::size_t initial = 4096;
+    if constexpr (detail::contiguous_input<In>)
+      initial = std::clamp(std::size_t(in.last - in.pos), initial, std::max(initial, max_initial));
+
+    document<T> doc(initial);
+    reader<In> r(in, doc.arena.get());
+    r.read(doc.value);
+    return doc;
+  }
+
 } // namespace lock3
 
 #endif
\ No newline at end of file
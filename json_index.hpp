@@ -0,0 +1,314 @@
+#ifndef LOCK3_JSON_INDEX_HPP
+#define LOCK3_JSON_INDEX_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#endif
+
+namespace lock3::json
+{
+  namespace detail
+  {
+    // The characters of a 64-byte block that are of interest to the
+    // structural index, one bit per byte.
+    struct block_classes
+    {
+      std::uint64_t quote;
+      std::uint64_t backslash;
+      std::uint64_t space;
+      std::uint64_t op;
+    };
+
+    inline block_classes classify_scalar(char const* p) noexcept
+    {
+      block_classes b {};
+      for (std::size_t i = 0; i != 64; ++i) {
+        std::uint64_t bit = std::uint64_t(1) << i;
+        switch (p[i]) {
+        case '"': b.quote |= bit; break;
+        case '\\': b.backslash |= bit; break;
+        case ' ': case '\t': case '\n': case '\r': b.space |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',': b.op |= bit; break;
+        default: break;
+        }
+      }
+      return b;
+    }
+
+#if defined(__SSE2__)
+    inline __m128i bytes_equal(__m128i x, char c) noexcept
+    {
+      return _mm_cmpeq_epi8(x, _mm_set1_epi8(c));
+    }
+
+    inline std::uint64_t mask_bits(__m128i x, std::size_t i) noexcept
+    {
+      return std::uint64_t(unsigned(_mm_movemask_epi8(x))) << (16 * i);
+    }
+
+    inline block_classes classify_sse2(char const* p) noexcept
+    {
+      block_classes b {};
+      for (std::size_t i = 0; i != 4; ++i) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 16 * i));
+        __m128i space = _mm_or_si128(_mm_or_si128(bytes_equal(x, ' '), bytes_equal(x, '\t')),
+                                     _mm_or_si128(bytes_equal(x, '\n'), bytes_equal(x, '\r')));
+        __m128i braces = _mm_or_si128(bytes_equal(x, '{'), bytes_equal(x, '}'));
+        __m128i brackets = _mm_or_si128(bytes_equal(x, '['), bytes_equal(x, ']'));
+        __m128i separators = _mm_or_si128(bytes_equal(x, ':'), bytes_equal(x, ','));
+        __m128i op = _mm_or_si128(_mm_or_si128(braces, brackets), separators);
+        b.quote |= mask_bits(bytes_equal(x, '"'), i);
+        b.backslash |= mask_bits(bytes_equal(x, '\\'), i);
+        b.space |= mask_bits(space, i);
+        b.op |= mask_bits(op, i);
+      }
+      return b;
+    }
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+    // These are compiled for AVX2 regardless of the target, and only called
+    // if the processor supports it.
+
+    __attribute__((target("avx2")))
+    inline __m256i bytes_equal(__m256i x, char c) noexcept
+    {
+      return _mm256_cmpeq_epi8(x, _mm256_set1_epi8(c));
+    }
+
+    __attribute__((target("avx2")))
+    inline std::uint64_t mask_bits(__m256i x, std::size_t i) noexcept
+    {
+      return std::uint64_t(unsigned(_mm256_movemask_epi8(x))) << (32 * i);
+    }
+
+    __attribute__((target("avx2")))
+    inline block_classes classify_avx2(char const* p) noexcept
+    {
+      block_classes b {};
+      for (std::size_t i = 0; i != 2; ++i) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + 32 * i));
+        __m256i space = _mm256_or_si256(_mm256_or_si256(bytes_equal(x, ' '), bytes_equal(x, '\t')),
+                                        _mm256_or_si256(bytes_equal(x, '\n'), bytes_equal(x, '\r')));
+        __m256i braces = _mm256_or_si256(bytes_equal(x, '{'), bytes_equal(x, '}'));
+        __m256i brackets = _mm256_or_si256(bytes_equal(x, '['), bytes_equal(x, ']'));
+        __m256i separators = _mm256_or_si256(bytes_equal(x, ':'), bytes_equal(x, ','));
+        __m256i op = _mm256_or_si256(_mm256_or_si256(braces, brackets), separators);
+        b.quote |= mask_bits(bytes_equal(x, '"'), i);
+        b.backslash |= mask_bits(bytes_equal(x, '\\'), i);
+        b.space |= mask_bits(space, i);
+        b.op |= mask_bits(op, i);
+      }
+      return b;
+    }
+#endif
+
+    using classify_fn = block_classes (*)(char const*) noexcept;
+
+    // Selects the widest classifier the processor supports, once.
+    inline classify_fn select_classifier() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      if (__builtin_cpu_supports("avx2"))
+        return classify_avx2;
+#endif
+#if defined(__SSE2__)
+      return classify_sse2;
+#else
+      return classify_scalar;
+#endif
+    }
+
+    // Returns the bits of the characters escaped by a backslash: those that
+    // follow an odd-length run of backslashes. `carry` is set if the block
+    // ends in such a run, so that the first character of the next block is
+    // escaped.
+    inline std::uint64_t escaped_bits(std::uint64_t backslash, std::uint64_t& carry) noexcept
+    {
+      constexpr std::uint64_t even = 0x5555555555555555ull;
+      constexpr std::uint64_t odd = ~even;
+      std::uint64_t starts = backslash & ~(backslash << 1);
+      std::uint64_t even_start_mask = even ^ carry;
+      std::uint64_t even_starts = starts & even_start_mask;
+      std::uint64_t odd_starts = starts & ~even_start_mask;
+      std::uint64_t even_carries = backslash + even_starts;
+      std::uint64_t odd_carries = backslash + odd_starts;
+      bool overflow = odd_carries < backslash;
+      odd_carries |= carry;
+      carry = overflow ? 1 : 0;
+      std::uint64_t even_carry_ends = even_carries & ~backslash;
+      std::uint64_t odd_carry_ends = odd_carries & ~backslash;
+      return (even_carry_ends & odd) | (odd_carry_ends & even);
+    }
+
+    // Returns the running XOR of the bits of `x`, from least to most
+    // significant: bit `i` is set if an odd number of bits at or below `i`
+    // are set.
+    constexpr std::uint64_t prefix_xor(std::uint64_t x) noexcept
+    {
+      x ^= x << 1;
+      x ^= x << 2;
+      x ^= x << 4;
+      x ^= x << 8;
+      x ^= x << 16;
+      x ^= x << 32;
+      return x;
+    }
+  } // namespace detail
+
+  /// The positions in a JSON text of its structural characters, in order.
+  /// These are the brackets, braces, colons and commas outside of strings,
+  /// the opening and closing quotes of strings, and the first character of
+  /// every other value (numbers, true, false and null). Every non-whitespace
+  /// character that a reader can find after skipping whitespace is in the
+  /// index.
+  ///
+  /// The text is classified 64 bytes at a time, with AVX2 when the
+  /// processor supports it, SSE2 otherwise, or a scalar loop on other
+  /// targets. Each block yields bitmasks of quotes, backslashes, whitespace
+  /// and operators; escaped quotes are removed, strings are masked by the
+  /// running XOR of the quotes, and the remaining bits are extracted.
+  ///
+  /// Positions are 32 bits, so the text must be smaller than 4 GiB.
+  class structural_index
+  {
+  public:
+    structural_index() = default;
+
+    explicit structural_index(std::string_view text)
+    {
+      assign(text);
+    }
+
+    /// Index `text`, reusing the storage of the previous index if it is
+    /// large enough. Reusing an index avoids faulting in new pages for each
+    /// document.
+    void assign(std::string_view text)
+    {
+      if (text.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("lock3::json::structural_index: text too long");
+
+      // There is at most one position per character. The storage is left
+      // uninitialized, so only the pages that are written are touched.
+      if (capacity < text.size() + 64) {
+        positions.reset(new std::uint32_t[text.size() + 64]);
+        capacity = text.size() + 64;
+      }
+      count = 0;
+
+      static detail::classify_fn const classify = detail::select_classifier();
+      std::uint64_t escape_carry = 0;
+      std::uint64_t in_string = 0;
+      std::uint64_t scalar_carry = 0;
+      for (std::size_t base = 0; base < text.size(); base += 64) {
+        // Pad the last block with spaces.
+        char tail[64];
+        char const* p = text.data() + base;
+        if (text.size() - base < 64) {
+          std::memset(tail, ' ', 64);
+          std::memcpy(tail, p, text.size() - base);
+          p = tail;
+        }
+
+        detail::block_classes b = classify(p);
+        std::uint64_t quotes = b.quote & ~detail::escaped_bits(b.backslash, escape_carry);
+
+        // The bits of characters inside strings, including their opening
+        // quotes but not their closing ones.
+        std::uint64_t strings = detail::prefix_xor(quotes) ^ in_string;
+        in_string = std::uint64_t(std::int64_t(strings) >> 63);
+
+        // Other values start at a character that is not an operator,
+        // whitespace or quote, and that does not follow one that isn't.
+        std::uint64_t scalar = ~(b.op | b.space | quotes);
+        std::uint64_t scalar_starts = scalar & ~((scalar << 1) | scalar_carry);
+        scalar_carry = scalar >> 63;
+
+        append(((b.op | scalar_starts) & ~strings) | quotes, base);
+      }
+    }
+
+    std::uint32_t operator[](std::size_t n) const noexcept
+    {
+      return positions[n];
+    }
+
+    std::size_t size() const noexcept
+    {
+      return count;
+    }
+
+  private:
+    // Append the positions of the bits of `bits`, four at a time, so that
+    // the loop exits after fewer mispredicted branches. Positions written
+    // past the new count are overwritten by the next block.
+    void append(std::uint64_t bits, std::size_t base) noexcept
+    {
+      std::uint32_t* out = positions.get() + count;
+      std::size_t n = std::popcount(bits);
+      for (std::size_t i = 0; i < n; i += 4) {
+        for (std::size_t j = 0; j != 4; ++j) {
+          out[i + j] = std::uint32_t(base + std::countr_zero(bits));
+          bits &= bits - 1;
+        }
+      }
+      count += n;
+    }
+
+    std::unique_ptr<std::uint32_t[]> positions;
+    std::size_t capacity = 0;
+    std::size_t count = 0;
+  };
+
+  /// Input for JSON readers from a contiguous range of characters, along
+  /// with its structural index. Readers use the index
+  /// to skip whitespace and to find the ends of strings without examining
+  /// each character.
+  struct indexed_input
+  {
+    explicit indexed_input(std::string_view str)
+      : first(str.data()), pos(str.data()), last(str.data() + str.size()),
+        index(str)
+    { }
+
+    /// Start reading `str`, reusing the storage of the index.
+    void reset(std::string_view str)
+    {
+      first = pos = str.data();
+      last = str.data() + str.size();
+      index.assign(str);
+      next = 0;
+    }
+
+    /// The start of the input.
+    char const* first;
+
+    /// The next character to be read.
+    char const* pos;
+
+    /// The end of the input.
+    char const* last;
+
+    /// The positions of the structural characters of the input.
+    structural_index index;
+
+    /// The first entry of the index that may be at or after `pos`.
+    std::size_t next = 0;
+  };
+
+} // namespace lock3::json
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef LOCK3_MAPPED_FILE_HPP
+#define LOCK3_MAPPED_FILE_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lock3
+{
+  /// A read-only memory mapping of a file. The contents can be parsed in
+  /// place (e.g., with json::string_input), without copying them through a
+  /// stream buffer.
+  ///
+  /// The mapping is advised for sequential access, so the kernel reads
+  /// ahead aggressively and drops pages behind the reader, and for huge
+  /// pages where the system supports them. Errors are reported by throwing
+  /// std::system_error.
+  class mapped_file
+  {
+  public:
+    mapped_file() = default;
+
+    explicit mapped_file(char const* path)
+    {
+      int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+        fail("open", path);
+
+      struct stat st;
+      if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        fail("stat", path);
+      }
+
+      // An empty file can't be mapped, and needn't be.
+      len = static_cast<std::size_t>(st.st_size);
+      if (len != 0) {
+        void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+          int err = errno;
+          ::close(fd);
+          errno = err;
+          fail("mmap", path);
+        }
+        addr = static_cast<char const*>(p);
+        ::madvise(p, len, MADV_SEQUENTIAL);
+#if defined(MADV_HUGEPAGE)
+        ::madvise(p, len, MADV_HUGEPAGE);
+#endif
+      }
+
+      // The mapping remains valid after the file is closed.
+      ::close(fd);
+    }
+
+    explicit mapped_file(std::string const& path)
+      : mapped_file(path.c_str())
+    { }
+
+    mapped_file(mapped_file&& other) noexcept
+      : addr(std::exchange(other.addr, nullptr)), len(std::exchange(other.len, 0))
+    { }
+
+    mapped_file& operator=(mapped_file&& other) noexcept
+    {
+      if (this != &other) {
+        unmap();
+        addr = std::exchange(other.addr, nullptr);
+        len = std::exchange(other.len, 0);
+      }
+      return *this;
+    }
+
+    ~mapped_file()
+    {
+      unmap();
+    }
+
+    char const* data() const noexcept
+    {
+      return addr;
+    }
+
+    std::size_t size() const noexcept
+    {
+      return len;
+    }
+
+    std::string_view view() const noexcept
+    {
+      return {addr, len};
+    }
+
+  private:
+    [[noreturn]] static void fail(char const* what, char const* path)
+    {
+      throw std::system_error(errno, std::generic_category(),
+                              std::string("lock3::mapped_file: ") + what + " " + path);
+    }
+
+    void unmap() noexcept
+    {
+      if (addr)
+        ::munmap(const_cast<char*>(addr), len);
+    }
+
+    char const* addr = nullptr;
+    std::size_t len = 0;
+  };
+
+} // namespace lock3
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef LOCK3_PERFECT_HASH_HPP
+#define LOCK3_PERFECT_HASH_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace lock3
+{
+  namespace detail
+  {
+    // FNV-1a over the characters of `str`. Perfect hash tables hash each
+    // key exactly once; the per-table seed is mixed in afterwards.
+    constexpr std::uint64_t perfect_hash_string(std::string_view str) noexcept
+    {
+      std::uint64_t code = 14695981039346656037ull;
+      for (char c : str)
+        code = (code ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+      return code;
+    }
+
+    // The splitmix64 finalizer, used to derive a slot from a hash code and
+    // a bucket's seed.
+    constexpr std::uint64_t perfect_hash_mix(std::uint64_t x) noexcept
+    {
+      x ^= x >> 30;
+      x *= 0xbf58476d1ce4e5b9ull;
+      x ^= x >> 27;
+      x *= 0x94d049bb133111ebull;
+      x ^= x >> 31;
+      return x;
+    }
+  } // namespace detail
+
+  /// A perfect hash table over a fixed set of `N` strings, built at compile
+  /// time with the hash-and-displace (CHD) algorithm.
+  ///
+  /// Each key is hashed once. The high bits of its hash code select a
+  /// bucket, and the bucket's seed is mixed into the code to select a slot.
+  /// Seeds are chosen, largest buckets first, so that no two keys share a
+  /// slot. A lookup therefore costs one hash of the string, two table
+  /// loads, and a single string comparison to reject keys not in the set.
+  template<std::size_t N>
+  class perfect_hash
+  {
+  public:
+    /// Returned by find() for strings that are not keys.
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    /// The number of buckets, about four keys each.
+    static constexpr std::size_t bucket_count = N / 4 + 1;
+
+    /// The number of slots, a power of two at least 5/4 of the number of
+    /// keys, which keeps the search for seeds short.
+    static constexpr std::size_t table_size = std::bit_ceil(N + N / 4 + 1);
+
+    /// Builds the table. The keys must be distinct.
+    constexpr explicit perfect_hash(std::array<std::string_view, N> const& keys)
+      : keys(keys)
+    {
+      std::array<std::uint64_t, N> codes {};
+      std::array<std::size_t, bucket_count> sizes {};
+      std::array<std::size_t, N> order {};
+      for (std::size_t i = 0; i != N; ++i) {
+        codes[i] = detail::perfect_hash_string(keys[i]);
+        ++sizes[bucket_of(codes[i])];
+        order[i] = i;
+      }
+
+      // Group keys by bucket, largest buckets first.
+      std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        std::size_t x = bucket_of(codes[a]);
+        std::size_t y = bucket_of(codes[b]);
+        if (sizes[x] != sizes[y])
+          return sizes[x] > sizes[y];
+        if (x != y)
+          return x < y;
+        return codes[a] < codes[b];
+      });
+
+      // Two keys with the same hash code cannot be separated by any seed.
+      for (std::size_t i = 1; i < N; ++i)
+        if (codes[order[i]] == codes[order[i - 1]])
+          throw std::invalid_argument("lock3::perfect_hash: duplicate key");
+
+      slots.fill(N);
+      std::size_t first = 0;
+      while (first != N) {
+        std::size_t bucket = bucket_of(codes[order[first]]);
+        std::size_t last = first + sizes[bucket];
+        seeds[bucket] = find_seed(codes, order, first, last);
+        for (std::size_t i = first; i != last; ++i)
+          slots[slot_of(codes[order[i]], seeds[bucket])] = order[i];
+        first = last;
+      }
+    }
+
+    /// Returns the index of `key` in the array the table was built from, or
+    /// npos if it is not one of the keys.
+    constexpr std::size_t find(std::string_view key) const noexcept
+    {
+      std::uint64_t code = detail::perfect_hash_string(key);
+      std::size_t index = slots[slot_of(code, seeds[bucket_of(code)])];
+      if (index == N || keys[index] != key)
+        return npos;
+      return index;
+    }
+
+    /// Returns the number of keys.
+    static constexpr std::size_t size() noexcept
+    {
+      return N;
+    }
+
+  private:
+    static constexpr std::size_t bucket_of(std::uint64_t code) noexcept
+    {
+      return (code >> 32) % bucket_count;
+    }
+
+    static constexpr std::size_t slot_of(std::uint64_t code, std::uint32_t seed) noexcept
+    {
+      return detail::perfect_hash_mix(code + seed * 0x9e3779b97f4a7c15ull) & (table_size - 1);
+    }
+
+    // Returns the first seed that puts the keys order[first, last) into
+    // distinct free slots.
+    constexpr std::uint32_t find_seed(std::array<std::uint64_t, N> const& codes,
+                                      std::array<std::size_t, N> const& order,
+                                      std::size_t first,
+                                      std::size_t last) const
+    {
+      for (std::uint32_t seed = 0; seed != (1u << 20); ++seed) {
+        bool fits = true;
+        for (std::size_t i = first; fits && i != last; ++i) {
+          std::size_t s = slot_of(codes[order[i]], seed);
+          fits = slots[s] == N;
+          for (std::size_t j = first; fits && j != i; ++j)
+            fits = slot_of(codes[order[j]], seed) != s;
+        }
+        if (fits)
+          return seed;
+      }
+      throw std::logic_error("lock3::perfect_hash: no seed found");
+    }
+
+    /// The keys, in their original order.
+    std::array<std::string_view, N> keys;
+
+    /// The seed of each bucket.
+    std::array<std::uint32_t, bucket_count> seeds {};
+
+    /// The index of the key in each slot, or N if the slot is empty.
+    std::array<std::size_t, table_size> slots {};
+  };
+
+  template<std::size_t N>
+  perfect_hash(std::array<std::string_view, N> const&) -> perfect_hash<N>;
+
+} // namespace lock3
+
+#endif
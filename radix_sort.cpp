@@ -0,0 +1,77 @@
+#include "radix_sort.hpp"
+#include "game.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+// A row of a batch job's player table.
+struct row
+{
+  std::string name;
+  int level;
+  float score;
+  enum class team : unsigned char { red, blue, green } side;
+};
+
+// Returns the number of milliseconds taken by `f`.
+template<typename F>
+double time_ms(F f)
+{
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+  return ms.count();
+}
+
+int main()
+{
+  constexpr std::size_t n = 1 << 22;
+  std::mt19937 rng(11);
+  std::vector<row> rows(n);
+  for (row& r : rows) {
+    r.name = "player" + std::to_string(rng() % 100000);
+    r.level = (int)(rng() % 100000) - 50000;
+    r.score = (float)(rng() % 1000) / 8 - 60;
+    r.side = row::team(rng() % 3);
+  }
+
+  std::cout << std::fixed << std::setprecision(1);
+
+  // By a numeric stat.
+  auto a = rows;
+  auto b = rows;
+  double radix = time_ms([&] { lock3::radix_sort_by<&row::level>(a); });
+  double comparison = time_ms([&] {
+    std::stable_sort(b.begin(), b.end(), [](row const& x, row const& y) {
+      return x.level < y.level;
+    });
+  });
+  for (std::size_t i = 0; i < n; ++i)
+    assert(a[i].name == b[i].name && a[i].level == b[i].level);
+  std::cout << "level:              " << std::setw(8) << radix << " ms radix"
+            << std::setw(8) << comparison << " ms stable_sort\n";
+
+  // By several members, including a string.
+  a = rows;
+  b = rows;
+  radix = time_ms([&] { lock3::radix_sort_by<&row::side, &row::name, &row::score>(a); });
+  comparison = time_ms([&] {
+    std::stable_sort(b.begin(), b.end(), [](row const& x, row const& y) {
+      return std::tie(x.side, x.name, x.score) < std::tie(y.side, y.name, y.score);
+    });
+  });
+  for (std::size_t i = 0; i < n; ++i)
+    assert(a[i].name == b[i].name && a[i].level == b[i].level);
+  std::cout << "side, name, score:  " << std::setw(8) << radix << " ms radix"
+            << std::setw(8) << comparison << " ms stable_sort\n";
+
+  std::vector<game::player> players {{"bob", {}, {}}, {"alice", {}, {}}, {"", {}, {}}};
+  lock3::radix_sort_by<&game::player::name>(players);
+  assert(players[0].name == "" && players[1].name == "alice" && players[2].name == "bob");
+}
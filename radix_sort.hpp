@@ -0,0 +1,230 @@
+#ifndef LOCK3_RADIX_SORT_HPP
+#define LOCK3_RADIX_SORT_HPP
+
+#include "concepts.hpp"
+#include "sort_key.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lock3
+{
+  namespace detail
+  {
+    // The class and member types of a pointer to data member.
+    template<typename P>
+    struct member_pointer_traits;
+
+    template<typename T, typename M>
+    struct member_pointer_traits<M T::*>
+    {
+      using class_type = T;
+      using member_type = M;
+    };
+
+    template<auto P>
+    using member_class_t = typename member_pointer_traits<decltype(P)>::class_type;
+
+    template<auto P>
+    using member_type_t =
+      std::remove_cv_t<typename member_pointer_traits<decltype(P)>::member_type>;
+
+    // Members that can be used as radix sort keys.
+    template<typename M>
+    concept radix_key = ordered_scalar<M> || string_like<M>;
+
+    // Stably sorts `a` by the first element of each pair, least significant
+    // byte first. The histograms of every byte are collected in one pass,
+    // and bytes that are the same in every key are skipped.
+    template<typename U, typename I>
+    void lsd_radix_sort(std::vector<std::pair<U, I>>& a, std::vector<std::pair<U, I>>& tmp)
+    {
+      constexpr std::size_t passes = sizeof(U);
+      std::array<std::array<std::size_t, 256>, passes> counts {};
+      for (auto const& e : a)
+        for (std::size_t p = 0; p != passes; ++p)
+          ++counts[p][(e.first >> (8 * p)) & 0xff];
+
+      tmp.resize(a.size());
+      for (std::size_t p = 0; p != passes; ++p) {
+        std::array<std::size_t, 256>& c = counts[p];
+        if (c[(a.front().first >> (8 * p)) & 0xff] == a.size())
+          continue;
+        std::size_t sum = 0;
+        for (std::size_t& n : c)
+          sum += std::exchange(n, sum);
+        for (auto const& e : a)
+          tmp[c[(e.first >> (8 * p)) & 0xff]++] = e;
+        a.swap(tmp);
+      }
+    }
+
+    // Below this many strings, a bucket is sorted by comparison.
+    constexpr std::size_t msd_cutoff = 32;
+
+    // Stably sorts the `n` strings at `a` that share their first `depth`
+    // characters, most significant character first. Strings that end at
+    // `depth` go first, in a bucket of their own.
+    template<typename I>
+    void msd_radix_sort(std::pair<std::string_view, I>* a,
+                        std::pair<std::string_view, I>* tmp,
+                        std::size_t n,
+                        std::size_t depth)
+    {
+      if (n < msd_cutoff) {
+        std::stable_sort(a, a + n, [depth](auto const& x, auto const& y) {
+          return x.first.substr(depth) < y.first.substr(depth);
+        });
+        return;
+      }
+
+      auto bucket_of = [&depth](std::string_view s) -> std::size_t {
+        return s.size() == depth ? 0 : std::size_t((unsigned char)s[depth]) + 1;
+      };
+
+      // Skip characters that all of the strings share.
+      std::array<std::size_t, 258> starts;
+      for (;;) {
+        starts = {};
+        for (std::size_t i = 0; i != n; ++i)
+          ++starts[bucket_of(a[i].first) + 1];
+        std::size_t b = bucket_of(a[0].first);
+        if (b == 0 || starts[b + 1] != n)
+          break;
+        ++depth;
+      }
+      for (std::size_t b = 1; b != starts.size(); ++b)
+        starts[b] += starts[b - 1];
+
+      std::array<std::size_t, 257> next;
+      std::copy_n(starts.begin(), next.size(), next.begin());
+      for (std::size_t i = 0; i != n; ++i)
+        tmp[next[bucket_of(a[i].first)]++] = a[i];
+      std::copy_n(tmp, n, a);
+
+      for (std::size_t b = 1; b != 257; ++b) {
+        std::size_t first = starts[b];
+        std::size_t count = starts[b + 1] - first;
+        if (count > 1)
+          msd_radix_sort(a + first, tmp, count, depth + 1);
+      }
+    }
+
+    // Stably reorders `perm`, a permutation of the elements of `range`, by
+    // the member `P` of each element.
+    //
+    // The keys are first copied out of the elements in order, so that the
+    // permuted accesses read a compact array instead of whole elements.
+    template<auto P, typename R, typename I>
+    void radix_pass(R const& range, std::vector<I>& perm)
+    {
+      using M = member_type_t<P>;
+      std::size_t n = perm.size();
+      if constexpr (ordered_scalar<M>) {
+        using U = decltype(ordered_bits(std::declval<M>()));
+        std::vector<U> column;
+        column.reserve(n);
+        for (auto const& elem : range)
+          column.push_back(ordered_bits(elem.*P));
+        std::vector<std::pair<U, I>> keys(n);
+        std::vector<std::pair<U, I>> tmp;
+        for (std::size_t i = 0; i != n; ++i)
+          keys[i] = {column[perm[i]], perm[i]};
+        lsd_radix_sort(keys, tmp);
+        for (std::size_t i = 0; i != n; ++i)
+          perm[i] = keys[i].second;
+      }
+      else {
+        std::vector<std::string_view> column;
+        column.reserve(n);
+        for (auto const& elem : range)
+          column.push_back(std::string_view(elem.*P));
+        std::vector<std::pair<std::string_view, I>> keys(n);
+        std::vector<std::pair<std::string_view, I>> tmp(n);
+        for (std::size_t i = 0; i != n; ++i)
+          keys[i] = {column[perm[i]], perm[i]};
+        msd_radix_sort(keys.data(), tmp.data(), n, 0);
+        for (std::size_t i = 0; i != n; ++i)
+          perm[i] = keys[i].second;
+      }
+    }
+
+    template<typename I, auto... Ps, typename R>
+    void radix_sort_by(R& range)
+    {
+      std::size_t n = std::ranges::size(range);
+      std::vector<I> perm(n);
+      for (std::size_t i = 0; i != n; ++i)
+        perm[i] = static_cast<I>(i);
+
+      // Sort by the least significant key first. Each pass is stable, so
+      // the elements end up ordered by all of the keys.
+      constexpr std::size_t num = sizeof...(Ps);
+      [&]<std::size_t... K>(std::index_sequence<K...>) {
+        (radix_pass<std::get<num - 1 - K>(std::tuple {Ps...})>(range, perm), ...);
+      }(std::make_index_sequence<num>());
+
+      // Move the elements into place, prefetching the elements that will be
+      // moved a few steps later.
+      constexpr std::size_t prefetch_distance = 16;
+      using T = std::ranges::range_value_t<R>;
+      auto first = std::ranges::begin(range);
+      std::vector<T> sorted;
+      sorted.reserve(n);
+      for (std::size_t i = 0; i != n; ++i) {
+        if (i + prefetch_distance < n)
+          __builtin_prefetch(std::addressof(first[perm[i + prefetch_distance]]));
+        sorted.push_back(std::move(first[perm[i]]));
+      }
+      std::ranges::move(sorted, first);
+    }
+  } // namespace detail
+
+  /// Sorts the elements of `range` by the members `Ps`: first by the first
+  /// member, then by the second among elements whose first members are
+  /// equivalent, and so on. The order of each member is the order given by
+  /// lock3::compare. The sort is stable.
+  ///
+  /// Members may be integers, enumerations, floating point numbers and
+  /// strings. Numeric members are sorted with least-significant-byte-first
+  /// radix passes over their order-preserving bits (see sort_key), skipping
+  /// bytes that are the same in every element. Strings are sorted most
+  /// significant character first. With several members, each is sorted in a
+  /// stable pass, starting with the last.
+  ///
+  /// The passes reorder a permutation of (key, index) pairs rather than the
+  /// elements themselves, so each element is moved only once, at the end.
+  /// Keys are copied out of the elements in order before each pass.
+  ///
+  ///    lock3::radix_sort_by<&game::player::name>(players);
+  ///    lock3::radix_sort_by<&record::level, &record::score>(records);
+  template<auto P, auto... Ps, std::ranges::random_access_range R>
+    requires std::ranges::sized_range<R> &&
+             std::same_as<std::ranges::range_value_t<R>, detail::member_class_t<P>> &&
+             (std::same_as<detail::member_class_t<P>, detail::member_class_t<Ps>> && ...) &&
+             detail::radix_key<detail::member_type_t<P>> &&
+             (detail::radix_key<detail::member_type_t<Ps>> && ...)
+  void radix_sort_by(R&& range)
+  {
+    if (std::ranges::size(range) < 2)
+      return;
+    if (std::ranges::size(range) <= std::numeric_limits<std::uint32_t>::max())
+      detail::radix_sort_by<std::uint32_t, P, Ps...>(range);
+    else
+      detail::radix_sort_by<std::size_t, P, Ps...>(range);
+  }
+
+} // namespace lock3
+
+#endif
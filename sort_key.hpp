@@ -0,0 +1,218 @@
+#ifndef LOCK3_SORT_KEY_HPP
+#define LOCK3_SORT_KEY_HPP
+
+#include "concepts.hpp"
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include <experimental/meta>
+
+namespace lock3
+{
+  namespace detail
+  {
+    // A container that bytes can be appended to (e.g., std::string or
+    // std::vector<unsigned char>).
+    template<typename Out>
+    concept byte_sink =
+      requires (Out& out, unsigned char const* p) {
+        out.push_back(static_cast<typename Out::value_type>(*p));
+        out.insert(out.end(), p, p);
+      };
+
+    // Bytes that separate the elements of a string or range. An element is
+    // preceded by `key_more`, and the sequence ends with `key_end`, so that
+    // a prefix sorts before any longer sequence. In strings, a 0 byte is
+    // escaped as 0 0xff.
+    constexpr unsigned char key_end = 0x00;
+    constexpr unsigned char key_more = 0x01;
+    constexpr unsigned char key_escape = 0xff;
+
+    template<byte_sink Out>
+    void append_key_byte(Out& out, unsigned char c)
+    {
+      out.push_back(static_cast<typename Out::value_type>(c));
+    }
+
+    // Append the bits of `u` most significant byte first.
+    template<byte_sink Out, std::unsigned_integral U>
+    void append_key_bits(Out& out, U u)
+    {
+      unsigned char buf[sizeof(U)];
+      for (std::size_t i = 0; i != sizeof(U); ++i)
+        buf[i] = static_cast<unsigned char>(u >> (8 * (sizeof(U) - 1 - i)));
+      out.insert(out.end(), buf, buf + sizeof(U));
+    }
+
+    // The unsigned integer type with the same size as `T`.
+    template<typename T>
+    using key_bits_t =
+      std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+    // Scalars that map to unsigned integers in an order-preserving way.
+    template<typename T>
+    concept ordered_scalar =
+      std::integral<T> ||
+      enumeral<T> ||
+      (std::floating_point<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+
+    // Returns an unsigned integer whose order is the order of `t` under
+    // lock3::compare (see sort_key_fn).
+    template<ordered_scalar T>
+    constexpr auto ordered_bits(T t) noexcept
+    {
+      if constexpr (std::same_as<T, bool>) {
+        return static_cast<std::uint8_t>(t);
+      }
+      else if constexpr (enumeral<T>) {
+        return ordered_bits(static_cast<std::underlying_type_t<T>>(t));
+      }
+      else if constexpr (std::integral<T>) {
+        using U = std::make_unsigned_t<T>;
+        U u = static_cast<U>(t);
+        if constexpr (std::is_signed_v<T>)
+          u ^= U(1) << (std::numeric_limits<U>::digits - 1);
+        return u;
+      }
+      else {
+        using U = key_bits_t<T>;
+        constexpr U sign = U(1) << (sizeof(U) * 8 - 1);
+        if (t == 0)
+          t = 0;
+        if (t != t)
+          t = std::numeric_limits<T>::quiet_NaN();
+        U u = std::bit_cast<U>(t);
+        return (u & sign) ? U(~u) : U(u | sign);
+      }
+    }
+  } // namespace detail
+
+  /// Encodes objects as byte strings whose order, compared with memcmp (or
+  /// std::string's operator<), is the order given by lock3::compare. Sort
+  /// keys let records be sorted and indexed with byte comparisons and
+  /// radix methods instead of a memberwise comparator.
+  ///
+  /// The encodings are:
+  ///
+  ///  - unsigned integers: big-endian;
+  ///  - signed integers: big-endian with the sign bit flipped;
+  ///  - enumerations: as their underlying type;
+  ///  - floating point: IEEE 754 total order (the sign bit is flipped for
+  ///    positive values and all bits are flipped for negative ones), with -0
+  ///    encoded as 0 and every NaN as the same positive NaN;
+  ///  - strings: their characters, with 0 bytes escaped as 0 0xff, followed
+  ///    by the terminator 0 1;
+  ///  - other ranges: each element preceded by 1, followed by 0;
+  ///  - tuples and basic data types: the concatenation of their elements or
+  ///    members.
+  ///
+  /// Every encoding is either fixed-width or self-terminating, so the
+  /// concatenation of two keys compares as the pair would. Classes that
+  /// define their own `operator<=>` cannot be encoded, since their order is
+  /// not known.
+  struct sort_key_fn
+  {
+    /// Appends the sort key of `obj` to `out`.
+    template<typename T, detail::byte_sink Out>
+    void operator()(T const& obj, Out& out) const
+    {
+      append(out, obj);
+    }
+
+    /// Returns the sort key of `obj`.
+    template<typename T>
+    std::string operator()(T const& obj) const
+    {
+      std::string out;
+      append(out, obj);
+      return out;
+    }
+
+    template<detail::byte_sink Out, detail::ordered_scalar T>
+    static void append(Out& out, T t)
+    {
+      detail::append_key_bits(out, detail::ordered_bits(t));
+    }
+
+    /// Append everything else.
+    template<detail::byte_sink Out, typename T>
+      requires class_type<T> || std::is_array_v<T>
+    static void append(Out& out, T const& obj)
+    {
+      if constexpr (string_like<T>)
+        append_string(out, std::string_view(obj));
+      else if constexpr (std::ranges::range<T>)
+        append_range(out, obj);
+      else if constexpr (detail::std_product_type<T>)
+        append_tuple(out, obj);
+      else if constexpr (std::three_way_comparable<T>)
+        static_assert(dependent_false<T>(), "cannot encode a user-defined ordering");
+      else // basic_data_type<T>
+        append_data_type(out, obj);
+    }
+
+    // Copy runs of non-zero bytes at once, escaping the zeros between them.
+    template<detail::byte_sink Out>
+    static void append_string(Out& out, std::string_view str)
+    {
+      unsigned char const* p = reinterpret_cast<unsigned char const*>(str.data());
+      unsigned char const* last = p + str.size();
+      while (p != last) {
+        unsigned char const* zero = p;
+        while (zero != last && *zero != 0)
+          ++zero;
+        out.insert(out.end(), p, zero);
+        if (zero == last)
+          break;
+        detail::append_key_byte(out, 0);
+        detail::append_key_byte(out, detail::key_escape);
+        p = zero + 1;
+      }
+      detail::append_key_byte(out, detail::key_end);
+      detail::append_key_byte(out, detail::key_more);
+    }
+
+    template<detail::byte_sink Out, std::ranges::range R>
+    static void append_range(Out& out, R const& range)
+    {
+      for (auto const& elem : range) {
+        detail::append_key_byte(out, detail::key_more);
+        append(out, elem);
+      }
+      detail::append_key_byte(out, detail::key_end);
+    }
+
+    template<detail::byte_sink Out, detail::std_product_type T>
+    static void append_tuple(Out& out, T const& obj)
+    {
+      template for (constexpr std::size_t I : ints(std::tuple_size_v<T>))
+        append(out, std::get<I>(obj));
+    }
+
+    template<detail::byte_sink Out, basic_data_type T>
+    static void append_data_type(Out& out, T const& obj)
+    {
+      namespace meta = std::experimental::meta;
+      constexpr auto subobjects = meta::subobjects_of(^T, meta::is_data_member);
+      constexpr std::size_t num = size(subobjects);
+      template for (constexpr std::size_t I : ints(num)) {
+        constexpr meta::info sub = *std::next(subobjects.begin(), I);
+        append(out, obj.[:sub:]);
+      }
+    }
+  };
+
+  constexpr sort_key_fn sort_key;
+
+} // namespace lock3
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef LOCK3_TREE_HASH_HPP
+#define LOCK3_TREE_HASH_HPP
+
+#include "hash.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace lock3
+{
+  /// A hash algorithm adapter that hashes very large inputs in parallel.
+  ///
+  /// The input is divided into chunks of `Chunk` bytes, counted from the
+  /// first byte hashed. Each chunk is hashed independently with `H`, and the
+  /// chunk digests are hashed, in order, into a root hash, followed by the
+  /// total number of bytes. This is a two-level Merkle tree.
+  ///
+  /// Because chunk boundaries depend only on byte positions, the result does
+  /// not depend on the number of threads or on how the input is divided
+  /// between calls. It is, however, a different function than `H` itself.
+  ///
+  /// Parallelism only applies within a single call that spans at least two
+  /// whole chunks (e.g., hash_append of a large vector<unsigned char>). Many
+  /// small appends are hashed sequentially.
+  template<hash_algorithm H, std::size_t Chunk = (1u << 20)>
+  struct tree_hasher
+  {
+    static_assert(Chunk != 0);
+
+    using result_type = hash_result_t<H>;
+
+    /// Use one thread per hardware thread.
+    tree_hasher()
+      : tree_hasher(std::thread::hardware_concurrency())
+    {
+    }
+
+    /// Use at most `n` threads, including the calling thread.
+    explicit tree_hasher(unsigned n)
+      : threads(n != 0 ? n : 1)
+    {
+    }
+
+    /// Hash bytes into the tree.
+    void operator()(const void* p, std::size_t n) noexcept
+    {
+      unsigned char const* first = static_cast<unsigned char const*>(p);
+      total += n;
+
+      // Finish the current chunk.
+      if (fill != 0) {
+        std::size_t k = n < Chunk - fill ? n : Chunk - fill;
+        leaf(first, k);
+        fill += k;
+        first += k;
+        n -= k;
+        if (fill != Chunk)
+          return;
+        append_leaf(leaf);
+        leaf = H();
+        fill = 0;
+      }
+
+      // Hash whole chunks, possibly in parallel.
+      if (std::size_t chunks = n / Chunk; chunks != 0) {
+        append_chunks(first, chunks);
+        first += chunks * Chunk;
+        n -= chunks * Chunk;
+      }
+
+      // Start a new chunk with what's left.
+      if (n != 0) {
+        leaf(first, n);
+        fill = n;
+      }
+    }
+
+    /// Converts to the computed hash code.
+    explicit operator result_type() const noexcept
+    {
+      H copy = root;
+      if (fill != 0 || total == 0) {
+        result_type code = (result_type)leaf;
+        copy(&code, sizeof(code));
+      }
+      copy(&total, sizeof(total));
+      return (result_type)copy;
+    }
+
+  private:
+    // Hash the digest of a completed chunk into the root.
+    void append_leaf(H const& hash) noexcept
+    {
+      result_type code = (result_type)hash;
+      root(&code, sizeof(code));
+    }
+
+    // Hash `count` whole chunks starting at `first`.
+    void append_chunks(unsigned char const* first, std::size_t count) noexcept
+    {
+      std::size_t workers = count < threads ? count : threads;
+      if (workers >= 2 && append_chunks_parallel(first, count, workers))
+        return;
+      for (std::size_t i = 0; i != count; ++i) {
+        H hash;
+        hash(first + i * Chunk, Chunk);
+        append_leaf(hash);
+      }
+    }
+
+    // Hash `count` whole chunks starting at `first` with up to `workers`
+    // threads. Returns false, having hashed nothing, if there is no memory
+    // for the chunk digests or the threads.
+    bool append_chunks_parallel(unsigned char const* first,
+                                std::size_t count,
+                                std::size_t workers) noexcept
+    {
+      std::vector<result_type> codes;
+      std::vector<std::thread> pool;
+      try {
+        codes.resize(count);
+        pool.reserve(workers - 1);
+      }
+      catch (...) {
+        return false;
+      }
+
+      // Workers claim chunks in order until none are left.
+      std::atomic<std::size_t> next = 0;
+      auto work = [&]() noexcept {
+        for (std::size_t i = next++; i < count; i = next++) {
+          H hash;
+          hash(first + i * Chunk, Chunk);
+          codes[i] = (result_type)hash;
+        }
+      };
+
+      // If a thread can't be started, the calling thread picks up the
+      // slack, so the result is the same either way.
+      try {
+        for (std::size_t i = 1; i != workers; ++i)
+          pool.emplace_back(work);
+      }
+      catch (...) {
+      }
+      work();
+      for (std::thread& t : pool)
+        t.join();
+
+      for (result_type code : codes)
+        root(&code, sizeof(code));
+      return true;
+    }
+
+    /// The maximum number of threads used to hash chunks.
+    std::size_t threads;
+
+    /// Hashes the digests of completed chunks.
+    H root;
+
+    /// Hashes the current, incomplete chunk.
+    H leaf;
+
+    /// The number of bytes in the current chunk.
+    std::size_t fill = 0;
+
+    /// The total number of bytes hashed.
+    std::uint64_t total = 0;
+  };
+
+} // namespace lock3
+
+#endif